@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "basins.hpp"
+
+// point group of the lattice: the diagonal t_prime bonds are only mapped onto
+// themselves by the identity, the inversion and the reflections on the
+// diagonals, which either keep or exchange x and y
+const int N_POINT_OPS = 4;
+
+static void point_op( const int& op, const int& x, const int& y,
+                      int& x_new, int& y_new )
+{
+  const int sign = ( op & 1 ) ? -1 : +1;
+  if ( op & 2 ) {
+    x_new = sign * y;
+    y_new = sign * x;
+  } else {
+    x_new = sign * x;
+    y_new = sign * y;
+  }
+}
+
+static bool close( const Array<fptype, Dynamic, 1>& a_up,
+                   const Array<fptype, Dynamic, 1>& a_down,
+                   const Array<fptype, Dynamic, 1>& b_up,
+                   const Array<fptype, Dynamic, 1>& b_down,
+                   const vector<int>& map, const fptype& tolerance )
+{
+  // compare a with the image of b under the site mapping
+  for ( size_t i = 0; i < map.size(); ++i ) {
+    if ( abs( a_up( i ) - b_up( map[i] ) ) > tolerance ||
+         abs( a_down( i ) - b_down( map[i] ) ) > tolerance ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool same_solution( const Array<fptype, Dynamic, 1>& n_up_a,
+                    const Array<fptype, Dynamic, 1>& n_down_a,
+                    const Array<fptype, Dynamic, 1>& n_up_b,
+                    const Array<fptype, Dynamic, 1>& n_down_b,
+                    const int& s, const fptype& tolerance )
+{
+  // check if the solutions a and b are mapped onto each other by a
+  // translation, a point group operation and/or flipping all spins
+
+  vector<int> map( s * s );
+  for ( int op = 0; op < N_POINT_OPS; ++op ) {
+    for ( int dy = 0; dy < s; ++dy ) {
+      for ( int dx = 0; dx < s; ++dx ) {
+
+        for ( int i = 0; i < s * s; ++i ) {
+          int x, y;
+          point_op( op, idx2x( i, s ), idx2y( i, s ), x, y );
+          map[i] = xy2idx( x + dx, y + dy, s );
+        }
+
+        if ( close( n_up_a, n_down_a, n_up_b, n_down_b, map, tolerance ) ||
+             close( n_up_a, n_down_a, n_down_b, n_up_b, map, tolerance ) ) {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+int merge_basin( vector<Basin>& basins, const Basin& basin,
+                 const int& s, const fptype& tolerance )
+{
+  // add the calculations of a basin to the matching one of the basins or
+  // append it as a new basin, returns the index of the basin
+
+  // solutions related by symmetry have the same energy, so only basins with
+  // practically the same energy need to be compared site by site
+  const fptype energy_window = 1e-3 * s * s;
+
+  for ( size_t b = 0; b < basins.size(); ++b ) {
+    if ( abs( basins[b].energy - basin.energy ) < energy_window &&
+         same_solution( basins[b].n_up, basins[b].n_down,
+                        basin.n_up, basin.n_down, s, tolerance ) ) {
+      basins[b].hits += basin.hits;
+      basins[b].energy = min( basins[b].energy, basin.energy );
+      return b;
+    }
+  }
+
+  basins.push_back( basin );
+  return basins.size() - 1;
+}
+
+int add_to_basins( vector<Basin>& basins, const SCCResults& results,
+                   const int& s, const fptype& tolerance )
+{
+  // add converged results to the basin they belong to or open a new one,
+  // returns the index of the basin
+  Basin basin;
+  basin.energy = results.energy;
+  basin.m_z = results.m_z;
+  basin.hits = 1;
+  basin.n_up = results.n_up;
+  basin.n_down = results.n_down;
+  return merge_basin( basins, basin, s, tolerance );
+}
+
+int lowest_basin( const vector<Basin>& basins )
+{
+  // index of the basin with the lowest energy (-1 if there is none)
+  int lowest = -1;
+  for ( size_t b = 0; b < basins.size(); ++b ) {
+    if ( lowest == -1 || basins[b].energy < basins[lowest].energy ) {
+      lowest = b;
+    }
+  }
+  return lowest;
+}
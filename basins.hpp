@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __BASINS_H_INCLUDED__
+#define __BASINS_H_INCLUDED__
+
+#include <vector>
+#include <cmath>
+using namespace std;
+
+#include <eigen3/Eigen/Core>
+using namespace Eigen;
+
+#include "typedefs.hpp"
+#include "lattice.hpp"
+#include "scc_inout.hpp"
+
+
+// a distinct converged solution (up to the symmetries of the lattice) and
+// the number of calculations that converged to it
+struct Basin {
+  fptype energy; // lowest energy of all calculations in the basin
+  fptype m_z;
+  int hits;
+
+  // mean field parameters of the first calculation in the basin
+  Array<fptype, Dynamic, 1> n_up;
+  Array<fptype, Dynamic, 1> n_down;
+};
+
+bool same_solution( const Array<fptype, Dynamic, 1>& n_up_a,
+                    const Array<fptype, Dynamic, 1>& n_down_a,
+                    const Array<fptype, Dynamic, 1>& n_up_b,
+                    const Array<fptype, Dynamic, 1>& n_down_b,
+                    const int& s, const fptype& tolerance );
+
+int merge_basin( vector<Basin>& basins, const Basin& basin,
+                 const int& s, const fptype& tolerance );
+
+int add_to_basins( vector<Basin>& basins, const SCCResults& results,
+                   const int& s, const fptype& tolerance );
+
+int lowest_basin( const vector<Basin>& basins );
+
+#endif //__BASINS_H_INCLUDED__
@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+using namespace std;
+
+#include <omp.h>
+
+#include "typedefs.hpp"
+#include "settings.hpp"
+#include "scc_inout.hpp"
+#include "scc_calc.hpp"
+#include "eigensolver.hpp"
+
+
+// the stages of a self-consistency cycle that are timed separately
+
+struct HtbStage {
+  GlobalSettings settings;
+  SCCWorkspace workspace;
+  void operator()() {
+    workspace.s = 0; // (forces the rebuild)
+    prepare_workspace( settings, workspace );
+  }
+};
+
+struct HsigmaStage {
+  Matrix<fptype, Dynamic, Dynamic> H_tb, H;
+  fptype U;
+  Array<fptype, Dynamic, 1> n_other;
+  bool diagonal_only;
+  void operator()() {
+    build_H_sigma( H_tb, U, n_other, H, diagonal_only );
+  }
+};
+
+struct DiagonalizeStage {
+  int backend, N_lowest, status;
+  Matrix<fptype, Dynamic, Dynamic> H_sigma, H, Q;
+  Array<fptype, Dynamic, 1> epsilon;
+  void operator()() {
+    H = H_sigma;
+    status = diagonalize( backend, H, N_lowest, epsilon, Q );
+  }
+};
+
+struct DensityStage {
+  Matrix<fptype, Dynamic, Dynamic> Q_up, Q_down;
+  int N_occ, threads;
+  Array<fptype, Dynamic, 1> n_up, n_down;
+  void operator()() {
+    occupied_density( Q_up, Q_down, N_occ, threads, n_up, n_down );
+  }
+};
+
+struct SCCStage {
+  GlobalSettings settings;
+  SCCWorkspace workspace;
+  SCCResults results;
+  void operator()() {
+    // (every calculation starts from the same random numbers, the stream
+    //  is keyed by settings.seed)
+    SCCResults fresh = run_scc( settings, 0, NULL, &workspace );
+    results.swap( fresh );
+  }
+};
+
+template <typename Stage>
+static void time_stage( const string& name, const int& s, const int& threads,
+                        const double& min_time, Stage& stage )
+{
+  // call the stage until min_time has passed (at least once after a first
+  // call that is not timed) and print the time per call
+  stage();
+  int calls = 0;
+  const double t_start = omp_get_wtime();
+  double t_used = 0.0;
+  do {
+    stage();
+    ++calls;
+    t_used = omp_get_wtime() - t_start;
+  } while ( t_used < min_time );
+
+  cout        << setw( 12 ) << name
+       << ' ' << setw( 6 )  << ( sizeof( fptype ) == sizeof( float ) ? "float"
+                                                                     : "double" )
+       << ' ' << setw( 4 )  << s
+       << ' ' << setw( 3 )  << threads
+       << ' ' << setw( 8 )  << calls
+       << ' ' << scientific << setprecision( 6 ) << t_used / calls << endl;
+}
+
+static vector<int> parse_ints( const string& value )
+{
+  vector<int> list;
+  stringstream in( value );
+  string item;
+  while ( getline( in, item, ',' ) ) {
+    list.push_back( atoi( item.c_str() ) );
+  }
+  return list;
+}
+
+int main( int argc, char* argv[] )
+{
+  // time the stages of the self-consistency cycle and a whole cycle for
+  // the lattice sizes and thread counts given on the command line
+  // usage: ./mfhub_bench [--seed=uint] [--min_time=float]
+  //                      [--thread_counts=list] [--scc_iterations=uint]
+  //                      [--name=value of mfhub ...] [s ...]
+
+  GlobalSettings settings = get_precompiled_settings();
+  settings.t_prime = 0.2 * settings.t;
+  settings.U = 4.0 * settings.t;
+  settings.plotmode = 0;
+
+  unsigned int seed = 1;
+  double min_time = 0.5;
+  int scc_iterations = 10;
+  vector<int> sizes, thread_counts;
+
+  for ( int i = 1; i < argc; ++i ) {
+    const string arg = argv[i];
+    if ( arg.compare( 0, 2, "--" ) != 0 ) {
+      sizes.push_back( atoi( arg.c_str() ) );
+      continue;
+    }
+    const size_t eq = arg.find( '=' );
+    const string name = arg.substr( 2, eq == string::npos ? string::npos
+                                                          : eq - 2 );
+    const string value = eq == string::npos ? "1" : arg.substr( eq + 1 );
+    if ( name == "seed" ) {
+      seed = atoi( value.c_str() );
+    } else if ( name == "min_time" ) {
+      min_time = atof( value.c_str() );
+    } else if ( name == "thread_counts" ) {
+      thread_counts = parse_ints( value );
+    } else if ( name == "scc_iterations" ) {
+      scc_iterations = atoi( value.c_str() );
+    } else if ( set_option( settings, name, value ) != 0 ) {
+      cerr << "ERROR: unknown option --" << name << endl;
+      return 1;
+    }
+  }
+  if ( sizes.empty() ) {
+    sizes.push_back( 8 );
+    sizes.push_back( 16 );
+    sizes.push_back( 32 );
+    sizes.push_back( 64 );
+  }
+  if ( thread_counts.empty() ) {
+    for ( int threads = 1; threads < omp_get_max_threads(); threads *= 2 ) {
+      thread_counts.push_back( threads );
+    }
+    thread_counts.push_back( omp_get_max_threads() );
+  }
+
+  // (a fixed number of iterations, so that every cycle does the same work)
+  settings.max_iterations = scc_iterations;
+  settings.m_prec = 0.0;
+  omp_set_max_active_levels( 3 );
+
+  cout << "#       stage precision  s threads  calls  seconds/call" << endl;
+  cout << "# seed = " << seed << ", diagonalizer = " << settings.diagonalizer
+       << ", scc_iterations = " << scc_iterations << endl;
+
+  const char* backends[] = { "eigen", "syevd", "syevr" };
+
+  for ( size_t i = 0; i < sizes.size(); ++i ) {
+    settings.s = sizes[i];
+    const int N = settings.s * settings.s;
+
+    // random mean field parameters and the matrices they lead to
+    srand( seed );
+    Array<fptype, Dynamic, 1> n( N );
+    for ( int j = 0; j < N; ++j ) {
+      n( j ) = rand() / static_cast<fptype>( RAND_MAX );
+    }
+
+    HtbStage htb;
+    htb.settings = settings;
+    time_stage( "H_tb", settings.s, 1, min_time, htb );
+
+    HsigmaStage hsigma;
+    hsigma.H_tb = htb.workspace.H_tb;
+    hsigma.U = settings.U;
+    hsigma.n_other = n;
+    // (like in the iterations only the diagonal is written with backend 0)
+    hsigma.diagonal_only = diagonalizer_preserves( settings.diagonalizer );
+    time_stage( "H_sigma", settings.s, 1, min_time, hsigma );
+
+    for ( size_t k = 0; k < thread_counts.size(); ++k ) {
+      const int threads = thread_counts[k];
+      omp_set_num_threads( threads );
+      Eigen::setNbThreads( threads );
+
+      DiagonalizeStage diag;
+      diag.H_sigma = hsigma.H;
+      diag.N_lowest = min( N / 2 + 2, N );
+      for ( diag.backend = 0; diag.backend <= 2; ++diag.backend ) {
+        if ( diagonalizer_available( diag.backend ) ) {
+          time_stage( string( "diag_" ) + backends[diag.backend],
+                      settings.s, threads, min_time, diag );
+        }
+      }
+
+      DensityStage density;
+      // (both spins, the eigenvectors of the second are a copy)
+      density.Q_up.swap( diag.Q );
+      density.Q_down = density.Q_up;
+      density.N_occ = N / 2;
+      density.threads = threads;
+      time_stage( "density", settings.s, threads, min_time, density );
+
+      SCCStage scc;
+      scc.settings = settings;
+      scc.settings.threads_per_scc = threads;
+      scc.settings.seed = seed;
+      // (the cycle with the float iterations of --precision=1 and the
+      //  fixed size kernel of small lattices are timed too)
+      scc.settings.precision = 0;
+      scc.settings.fixed_size = 0;
+      time_stage( "scc", settings.s, threads, min_time, scc );
+      if ( settings.precision == 1 && sizeof( fptype ) > sizeof( float ) ) {
+        scc.settings.precision = 1;
+        time_stage( "scc_mixed", settings.s, threads, min_time, scc );
+        scc.settings.precision = 0;
+      }
+      scc.settings.fixed_size = settings.fixed_size;
+      if ( fixed_size_available( scc.settings ) ) {
+        time_stage( "scc_fixed", settings.s, threads, min_time, scc );
+      }
+    }
+  }
+
+  return 0;
+}
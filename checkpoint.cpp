@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "checkpoint.hpp"
+
+// the files start with a magic string and the settings they belong to, so
+// that files of a different calculation are never picked up by --resume
+static const char magic[8] = { 'M', 'F', 'H', 'U', 'B', 'C', 'K', '3' };
+
+static void put_header( ofstream& out, const GlobalSettings& settings )
+{
+  const int ints[5] = { int( sizeof( fptype ) ), settings.s,
+                        settings.engine, settings.cell, settings.smearing };
+  const fptype fps[9] = { settings.t, settings.t_prime, settings.U,
+                          settings.spiral_qx, settings.spiral_qy,
+                          settings.filling, settings.smearing_width,
+                          settings.smearing_anneal, settings.smearing_final };
+  out.write( magic, sizeof( magic ) );
+  out.write( reinterpret_cast<const char*>( ints ), sizeof( ints ) );
+  out.write( reinterpret_cast<const char*>( fps ), sizeof( fps ) );
+}
+
+static bool check_header( ifstream& in, const GlobalSettings& settings )
+{
+  char file_magic[8];
+  int ints[5];
+  fptype fps[9];
+  in.read( file_magic, sizeof( file_magic ) );
+  in.read( reinterpret_cast<char*>( ints ), sizeof( ints ) );
+  in.read( reinterpret_cast<char*>( fps ), sizeof( fps ) );
+  return in.good() && memcmp( file_magic, magic, sizeof( magic ) ) == 0
+         && ints[0] == int( sizeof( fptype ) ) && ints[1] == settings.s
+         && ints[2] == settings.engine && ints[3] == settings.cell
+         && ints[4] == settings.smearing
+         && fps[0] == settings.t && fps[1] == settings.t_prime
+         && fps[2] == settings.U && fps[3] == settings.spiral_qx
+         && fps[4] == settings.spiral_qy && fps[5] == settings.filling
+         && fps[6] == settings.smearing_width
+         && fps[7] == settings.smearing_anneal
+         && fps[8] == settings.smearing_final;
+}
+
+template <typename T>
+static void put( ofstream& out, const T& x )
+{
+  out.write( reinterpret_cast<const char*>( &x ), sizeof( T ) );
+}
+
+template <typename T>
+static void get( ifstream& in, T& x )
+{
+  in.read( reinterpret_cast<char*>( &x ), sizeof( T ) );
+}
+
+static void put( ofstream& out, const Array<fptype, Dynamic, 1>& a )
+{
+  put( out, int( a.size() ) );
+  out.write( reinterpret_cast<const char*>( a.data() ),
+             a.size() * sizeof( fptype ) );
+}
+
+static void get( ifstream& in, Array<fptype, Dynamic, 1>& a )
+{
+  int size = 0;
+  get( in, size );
+  if ( !in.good() || size < 0 ) {
+    in.setstate( ios::failbit );
+    return;
+  }
+  a.resize( size );
+  in.read( reinterpret_cast<char*>( a.data() ), size * sizeof( fptype ) );
+}
+
+static void put( ofstream& out,
+                 const deque< Array<fptype, Dynamic, 1> >& history )
+{
+  put( out, int( history.size() ) );
+  for ( size_t i = 0; i < history.size(); ++i ) {
+    put( out, history[i] );
+  }
+}
+
+static void get( ifstream& in, deque< Array<fptype, Dynamic, 1> >& history )
+{
+  int size = 0;
+  get( in, size );
+  history.clear();
+  for ( int i = 0; i < size && in.good(); ++i ) {
+    history.push_back( Array<fptype, Dynamic, 1>() );
+    get( in, history.back() );
+  }
+}
+
+static int commit_file( const string& tmp, const string& file )
+{
+  // replace the file in one step, so a job killed while writing never leaves
+  // a truncated file behind
+  return rename( tmp.c_str(), file.c_str() ) == 0 ? 0 : 1;
+}
+
+string checkpoint_file( const GlobalSettings& settings, const int& id )
+{
+  stringstream name;
+  name << settings.checkpoint_prefix << "scc_" << id << ".chk";
+  return name.str();
+}
+
+string finished_file( const GlobalSettings& settings, const int& id )
+{
+  stringstream name;
+  name << settings.checkpoint_prefix << "done_" << id << ".chk";
+  return name.str();
+}
+
+bool checkpoint_due( const GlobalSettings& settings, const int& iter )
+{
+  return settings.checkpoint > 0 && !settings.checkpoint_prefix.empty()
+         && iter % settings.checkpoint == 0;
+}
+
+int write_checkpoint( const GlobalSettings& settings, const int& id,
+                      const int& iter,
+                      const Array<fptype, Dynamic, 1>& n_up,
+                      const Array<fptype, Dynamic, 1>& n_down,
+                      const MixerState& mixer, const gsl_rng* rng )
+{
+  const string file = checkpoint_file( settings, id );
+  {
+    ofstream out( ( file + ".tmp" ).c_str(), ios::binary );
+    if ( !out.is_open() ) {
+      return 1;
+    }
+    put_header( out, settings );
+    put( out, iter );
+    put( out, n_up );
+    put( out, n_down );
+    put( out, mixer.x_last );
+    put( out, mixer.f_last );
+    put( out, mixer.dx );
+    put( out, mixer.df );
+    put( out, mixer.u );
+    put( out, mixer.v );
+    put( out, int( gsl_rng_size( rng ) ) );
+    out.write( static_cast<const char*>( gsl_rng_state( rng ) ),
+               gsl_rng_size( rng ) );
+    if ( !out.good() ) {
+      return 1;
+    }
+  }
+  return commit_file( file + ".tmp", file );
+}
+
+int read_checkpoint( const GlobalSettings& settings, const int& id,
+                     SCCCheckpoint& checkpoint )
+{
+  ifstream in( checkpoint_file( settings, id ).c_str(), ios::binary );
+  if ( !in.is_open() || !check_header( in, settings ) ) {
+    return 1;
+  }
+  get( in, checkpoint.iter );
+  get( in, checkpoint.n_up );
+  get( in, checkpoint.n_down );
+  get( in, checkpoint.mixer.x_last );
+  get( in, checkpoint.mixer.f_last );
+  get( in, checkpoint.mixer.dx );
+  get( in, checkpoint.mixer.df );
+  get( in, checkpoint.mixer.u );
+  get( in, checkpoint.mixer.v );
+  int rng_size = 0;
+  get( in, rng_size );
+  if ( !in.good() || rng_size <= 0 ) {
+    return 1;
+  }
+  checkpoint.rng_state.resize( rng_size );
+  in.read( &checkpoint.rng_state[0], rng_size );
+  return in.good() ? 0 : 1;
+}
+
+int resume_checkpoint( const GlobalSettings& settings, const int& id,
+                       Array<fptype, Dynamic, 1>& n_up,
+                       Array<fptype, Dynamic, 1>& n_down,
+                       MixerState& mixer, gsl_rng* rng )
+{
+  // continue an interrupted calculation from its checkpoint if resuming,
+  // returns the number of iterations already done (0: start from scratch)
+  SCCCheckpoint checkpoint;
+  if ( !settings.resume || settings.checkpoint_prefix.empty()
+       || read_checkpoint( settings, id, checkpoint ) != 0
+       || checkpoint.n_up.size() != n_up.size()
+       || checkpoint.n_down.size() != n_down.size()
+       || checkpoint.rng_state.size() != gsl_rng_size( rng ) ) {
+    return 0;
+  }
+
+  n_up.swap( checkpoint.n_up );
+  n_down.swap( checkpoint.n_down );
+  mixer = checkpoint.mixer;
+  memcpy( gsl_rng_state( rng ), &checkpoint.rng_state[0],
+          checkpoint.rng_state.size() );
+  return checkpoint.iter;
+}
+
+int write_finished( const GlobalSettings& settings, const int& id,
+                    const SCCResults& results )
+{
+  const string file = finished_file( settings, id );
+  {
+    ofstream out( ( file + ".tmp" ).c_str(), ios::binary );
+    if ( !out.is_open() ) {
+      return 1;
+    }
+    put_header( out, settings );
+    put( out, results.exit_code );
+    put( out, results.converged );
+    put( out, results.pruned );
+    put( out, results.iterations_to_convergence );
+    put( out, results.Delta_n_up );
+    put( out, results.Delta_n_down );
+    put( out, results.energy );
+    put( out, results.gap );
+    put( out, results.m_z );
+    put( out, results.m_spiral );
+    put( out, results.filling );
+    put( out, results.n_up );
+    put( out, results.n_down );
+    put( out, results.epsilon_up );
+    put( out, results.epsilon_down );
+    if ( !out.good() ) {
+      return 1;
+    }
+  }
+  if ( commit_file( file + ".tmp", file ) != 0 ) {
+    return 1;
+  }
+  // the in-flight state is not needed anymore
+  remove( checkpoint_file( settings, id ).c_str() );
+  return 0;
+}
+
+int read_finished( const GlobalSettings& settings, const int& id,
+                   SCCResults& results )
+{
+  ifstream in( finished_file( settings, id ).c_str(), ios::binary );
+  if ( !in.is_open() || !check_header( in, settings ) ) {
+    return 1;
+  }
+  get( in, results.exit_code );
+  get( in, results.converged );
+  get( in, results.pruned );
+  get( in, results.iterations_to_convergence );
+  get( in, results.Delta_n_up );
+  get( in, results.Delta_n_down );
+  get( in, results.energy );
+  get( in, results.gap );
+  get( in, results.m_z );
+  get( in, results.m_spiral );
+  get( in, results.filling );
+  get( in, results.n_up );
+  get( in, results.n_down );
+  get( in, results.epsilon_up );
+  get( in, results.epsilon_down );
+  return in.good() ? 0 : 1;
+}
+
+void remove_checkpoints( const GlobalSettings& settings, const int& N_total )
+{
+  // delete the files of all calculations once their results are kept
+  // somewhere else
+  for ( int id = 0; id < N_total; ++id ) {
+    remove( checkpoint_file( settings, id ).c_str() );
+    remove( finished_file( settings, id ).c_str() );
+  }
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __CHECKPOINT_H_INCLUDED__
+#define __CHECKPOINT_H_INCLUDED__
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+using namespace std;
+
+#include <eigen3/Eigen/Core>
+using namespace Eigen;
+
+#include <gsl/gsl_rng.h>
+
+#include "typedefs.hpp"
+#include "settings.hpp"
+#include "scc_inout.hpp"
+#include "mixer.hpp"
+
+
+// state of a running self-consistency cycle after iteration iter
+struct SCCCheckpoint {
+  int iter;
+  Array<fptype, Dynamic, 1> n_up;
+  Array<fptype, Dynamic, 1> n_down;
+  MixerState mixer;
+  vector<char> rng_state;
+};
+
+// file names of the in-flight state and of the results of calculation id
+string checkpoint_file( const GlobalSettings& settings, const int& id );
+string finished_file( const GlobalSettings& settings, const int& id );
+
+bool checkpoint_due( const GlobalSettings& settings, const int& iter );
+
+int write_checkpoint( const GlobalSettings& settings, const int& id,
+                      const int& iter,
+                      const Array<fptype, Dynamic, 1>& n_up,
+                      const Array<fptype, Dynamic, 1>& n_down,
+                      const MixerState& mixer, const gsl_rng* rng );
+int read_checkpoint( const GlobalSettings& settings, const int& id,
+                     SCCCheckpoint& checkpoint );
+int resume_checkpoint( const GlobalSettings& settings, const int& id,
+                       Array<fptype, Dynamic, 1>& n_up,
+                       Array<fptype, Dynamic, 1>& n_down,
+                       MixerState& mixer, gsl_rng* rng );
+
+int write_finished( const GlobalSettings& settings, const int& id,
+                    const SCCResults& results );
+int read_finished( const GlobalSettings& settings, const int& id,
+                   SCCResults& results );
+
+void remove_checkpoints( const GlobalSettings& settings, const int& N_total );
+
+#endif //__CHECKPOINT_H_INCLUDED__
@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "distributed.hpp"
+
+#ifdef _MPI
+static MPI_Datatype mpi_fptype()
+{
+  return sizeof( fptype ) == sizeof( float ) ? MPI_FLOAT : MPI_DOUBLE;
+}
+#endif
+
+int mpi_rank()
+{
+#ifdef _MPI
+  int rank;
+  MPI_Comm_rank( MPI_COMM_WORLD, &rank );
+  return rank;
+#else
+  return 0;
+#endif
+}
+
+int mpi_size()
+{
+#ifdef _MPI
+  int size;
+  MPI_Comm_size( MPI_COMM_WORLD, &size );
+  return size;
+#else
+  return 1;
+#endif
+}
+
+void mpi_barrier()
+{
+#ifdef _MPI
+  MPI_Barrier( MPI_COMM_WORLD );
+#endif
+}
+
+void open_task_counter( TaskCounter& counter )
+{
+  counter.local = 0;
+#ifdef _MPI
+  // the global counter lives in a window on process 0 and is incremented by
+  // the others with passive target atomics, so process 0 does not have to
+  // take part in handing out the work
+  const MPI_Aint size = ( mpi_rank() == 0 ) ? sizeof( int ) : 0;
+  MPI_Win_allocate( size, sizeof( int ), MPI_INFO_NULL, MPI_COMM_WORLD,
+                    &counter.global, &counter.window );
+  if ( mpi_rank() == 0 ) {
+    MPI_Win_lock( MPI_LOCK_EXCLUSIVE, 0, 0, counter.window );
+    *counter.global = 0;
+    MPI_Win_unlock( 0, counter.window );
+  }
+  MPI_Barrier( MPI_COMM_WORLD );
+#endif
+}
+
+int next_task( TaskCounter& counter )
+{
+  int id;
+#ifdef _MPI
+  const int one = 1;
+  // (MPI is only initialized for serialized calls from the threads)
+  #pragma omp critical (mpi)
+  {
+    MPI_Win_lock( MPI_LOCK_SHARED, 0, 0, counter.window );
+    MPI_Fetch_and_op( &one, &id, MPI_INT, 0, 0, MPI_SUM, counter.window );
+    MPI_Win_unlock( 0, counter.window );
+  }
+#else
+  #pragma omp atomic capture
+  id = counter.local++;
+#endif
+  return id;
+}
+
+void close_task_counter( TaskCounter& counter )
+{
+#ifdef _MPI
+  MPI_Win_free( &counter.window );
+#else
+  counter.local = 0;
+#endif
+}
+
+void mpi_best_results( bool& found, SCCResults& results )
+{
+#ifdef _MPI
+  // find the process with the lowest energy ...
+  struct { fptype energy; int rank; } mine, best;
+  mine.energy = found ? results.energy : numeric_limits<fptype>::infinity();
+  mine.rank = mpi_rank();
+  MPI_Allreduce( &mine, &best, 1,
+                 sizeof( fptype ) == sizeof( float ) ? MPI_FLOAT_INT
+                                                     : MPI_DOUBLE_INT,
+                 MPI_MINLOC, MPI_COMM_WORLD );
+  found = ( best.energy < numeric_limits<fptype>::infinity() );
+  if ( !found ) {
+    return;
+  }
+
+  // ... and send its results to all others
+  const int owner = best.rank;
+  double scalars[11] = {
+    double( results.exit_code ), double( results.converged ),
+    double( results.pruned ), double( results.iterations_to_convergence ),
+    results.Delta_n_up, results.Delta_n_down,
+    results.energy, results.gap, results.m_z, results.filling,
+    results.m_spiral
+  };
+  MPI_Bcast( scalars, 11, MPI_DOUBLE, owner, MPI_COMM_WORLD );
+  results.exit_code = int( scalars[0] );
+  results.converged = ( scalars[1] != 0.0 );
+  results.pruned = ( scalars[2] != 0.0 );
+  results.iterations_to_convergence = int( scalars[3] );
+  results.Delta_n_up = scalars[4];
+  results.Delta_n_down = scalars[5];
+  results.energy = scalars[6];
+  results.gap = scalars[7];
+  results.m_z = scalars[8];
+  results.filling = scalars[9];
+  results.m_spiral = scalars[10];
+
+  int sizes[2] = { int( results.n_up.size() ),
+                   int( results.epsilon_up.size() ) };
+  MPI_Bcast( sizes, 2, MPI_INT, owner, MPI_COMM_WORLD );
+  results.n_up.resize( sizes[0] );
+  results.n_down.resize( sizes[0] );
+  results.epsilon_up.resize( sizes[1] );
+  results.epsilon_down.resize( sizes[1] );
+  MPI_Bcast( results.n_up.data(), sizes[0], mpi_fptype(), owner,
+             MPI_COMM_WORLD );
+  MPI_Bcast( results.n_down.data(), sizes[0], mpi_fptype(), owner,
+             MPI_COMM_WORLD );
+  MPI_Bcast( results.epsilon_up.data(), sizes[1], mpi_fptype(), owner,
+             MPI_COMM_WORLD );
+  MPI_Bcast( results.epsilon_down.data(), sizes[1], mpi_fptype(), owner,
+             MPI_COMM_WORLD );
+
+  // (the eigenvectors stay on the process that calculated them)
+  if ( mpi_rank() != owner ) {
+    results.Q_up.resize( 0, 0 );
+    results.Q_down.resize( 0, 0 );
+  }
+#else
+  ( void ) found;
+  ( void ) results;
+#endif
+}
+
+void mpi_gather_basins( vector<Basin>& basins, const int& s,
+                        const fptype& tolerance )
+{
+#ifdef _MPI
+  if ( mpi_rank() != 0 ) {
+    int count = basins.size();
+    MPI_Send( &count, 1, MPI_INT, 0, 0, MPI_COMM_WORLD );
+    for ( int b = 0; b < count; ++b ) {
+      double scalars[3] = {
+        basins[b].energy, basins[b].m_z, double( basins[b].hits )
+      };
+      MPI_Send( scalars, 3, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD );
+      MPI_Send( basins[b].n_up.data(), s * s, mpi_fptype(), 0, 0,
+                MPI_COMM_WORLD );
+      MPI_Send( basins[b].n_down.data(), s * s, mpi_fptype(), 0, 0,
+                MPI_COMM_WORLD );
+    }
+    return;
+  }
+
+  for ( int rank = 1; rank < mpi_size(); ++rank ) {
+    int count;
+    MPI_Recv( &count, 1, MPI_INT, rank, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE );
+    for ( int b = 0; b < count; ++b ) {
+      double scalars[3];
+      MPI_Recv( scalars, 3, MPI_DOUBLE, rank, 0, MPI_COMM_WORLD,
+                MPI_STATUS_IGNORE );
+      Basin basin;
+      basin.energy = scalars[0];
+      basin.m_z = scalars[1];
+      basin.hits = int( scalars[2] );
+      basin.n_up.resize( s * s );
+      basin.n_down.resize( s * s );
+      MPI_Recv( basin.n_up.data(), s * s, mpi_fptype(), rank, 0,
+                MPI_COMM_WORLD, MPI_STATUS_IGNORE );
+      MPI_Recv( basin.n_down.data(), s * s, mpi_fptype(), rank, 0,
+                MPI_COMM_WORLD, MPI_STATUS_IGNORE );
+      merge_basin( basins, basin, s, tolerance );
+    }
+  }
+#else
+  ( void ) basins;
+  ( void ) s;
+  ( void ) tolerance;
+#endif
+}
+
+int mpi_sum( const int& x )
+{
+#ifdef _MPI
+  int sum = 0;
+  MPI_Reduce( const_cast<int*>( &x ), &sum, 1, MPI_INT, MPI_SUM, 0,
+              MPI_COMM_WORLD );
+  return sum;
+#else
+  return x;
+#endif
+}
+
+double mpi_sum( const double& x )
+{
+#ifdef _MPI
+  double sum = 0.0;
+  MPI_Reduce( const_cast<double*>( &x ), &sum, 1, MPI_DOUBLE, MPI_SUM, 0,
+              MPI_COMM_WORLD );
+  return sum;
+#else
+  return x;
+#endif
+}
+
+bool mpi_all( const bool& ok )
+{
+#ifdef _MPI
+  int mine = ok ? 1 : 0;
+  int all = 0;
+  MPI_Allreduce( &mine, &all, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD );
+  return all != 0;
+#else
+  return ok;
+#endif
+}
+
+unsigned long mpi_broadcast( const unsigned long& x )
+{
+#ifdef _MPI
+  unsigned long y = x;
+  MPI_Bcast( &y, 1, MPI_UNSIGNED_LONG, 0, MPI_COMM_WORLD );
+  return y;
+#else
+  return x;
+#endif
+}
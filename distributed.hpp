@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __DISTRIBUTED_H_INCLUDED__
+#define __DISTRIBUTED_H_INCLUDED__
+
+#include <vector>
+#include <limits>
+using namespace std;
+
+#ifdef _MPI
+# include <mpi.h>
+#endif
+
+#include <eigen3/Eigen/Core>
+using namespace Eigen;
+
+#include "typedefs.hpp"
+#include "scc_inout.hpp"
+#include "basins.hpp"
+
+// helpers for running the calculations on several processes with MPI
+// (without _MPI there is a single process and they do nothing)
+
+int mpi_rank();
+int mpi_size();
+void mpi_barrier();
+
+// counter handing out the ids 0, 1, 2, ... to all threads of all processes,
+// opening and closing it has to be done by all processes together
+struct TaskCounter {
+  int local;
+#ifdef _MPI
+  MPI_Win window;
+  int* global;
+#endif
+};
+
+void open_task_counter( TaskCounter& counter );
+int next_task( TaskCounter& counter );
+void close_task_counter( TaskCounter& counter );
+
+// give all processes the results with the lowest energy of all processes
+void mpi_best_results( bool& found, SCCResults& results );
+
+// merge the basins of all processes on process 0
+void mpi_gather_basins( vector<Basin>& basins, const int& s,
+                        const fptype& tolerance );
+
+// sum of x over all processes on process 0
+int mpi_sum( const int& x );
+double mpi_sum( const double& x );
+
+// true on all processes if ok is true on all processes
+bool mpi_all( const bool& ok );
+
+// the value of x on process 0 on all processes
+unsigned long mpi_broadcast( const unsigned long& x );
+
+#endif //__DISTRIBUTED_H_INCLUDED__
@@ -0,0 +1,554 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "driver.hpp"
+
+int max_threads( const GlobalSettings& settings )
+{
+  // total number of threads available to the program
+#ifdef _OPENMP
+  return settings.threads > 0 ? settings.threads : omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+void schedule_threads( const GlobalSettings& settings, const int& N_total,
+                       int& outer, int& inner )
+{
+  // split the threads between concurrent calculations (outer) and threads
+  // inside every calculation (inner): independent calculations scale
+  // perfectly, so as many as possible run concurrently and only the threads
+  // left over are given to the calculations
+  const int T = max_threads( settings );
+
+  if ( settings.threads_per_scc > 0 ) {
+    inner = min( settings.threads_per_scc, T );
+    outer = max( 1, min( T / inner, N_total ) );
+  } else {
+    outer = max( 1, min( T, N_total ) );
+    inner = T / outer;
+    // (small matrices are not worth the synchronization)
+    if ( settings.s * settings.s < 256 ) {
+      inner = 1;
+    }
+  }
+}
+
+int prepare_output_dir( const string& dir, const bool& clean )
+{
+  // create the output directory, cleaning out an existing one unless the
+  // files of an interrupted run are needed
+  if ( make_dir( dir ) != 0 ) {
+    return 1;
+  }
+  return clean ? clean_dir( dir ) : 0;
+}
+
+static string process_file( const string& dir, const string& name,
+                            const string& extension )
+{
+  // file written by this process (process 0 writes the one without number)
+  stringstream file;
+  file << "./" << dir << "/" << name;
+  if ( mpi_rank() != 0 ) {
+    file << "_" << mpi_rank();
+  }
+  file << extension;
+  return file.str();
+}
+
+int open_results_store( const GlobalSettings& settings, const string& dir,
+                        ResultsStore& store )
+{
+  // every process writes its own store, process 0 the one with the ground
+  // state (a resumed run appends to the store of the interrupted one)
+  return open_store( store, process_file( dir, "results", ".mfr" ),
+                     settings.s,
+                     settings.store_eigenvalues ? settings.s * settings.s : 0,
+                     settings.resume );
+}
+
+int run_restarts( const GlobalSettings& settings, const string& dir,
+                  const vector<const SCCResults*>& starts,
+                  vector<SCCWorkspace>& workspaces, const bool& verbose,
+                  SCCResults& gs_candidate, RestartStats* stats,
+                  ResultsStore* store )
+{
+  // launch N_SCC independent calculations from the initialization given by
+  // the settings plus one calculation continuing from each of the starts,
+  // and keep the one with the lowest energy as the ground state candidate
+
+  // "best" simulation results = ground state
+  bool some_gsc_found = false; // will be set to true as soon as
+                               // one calculation finishes converged ...
+
+  const int N_total = settings.N_SCC + starts.size();
+
+  // energy of the best converged calculation for the pruning
+  SCCBound bound;
+
+  // no new calculations are started once stop is set by the adaptive stopping
+  RestartStats local_stats;
+  int stop = 0;
+
+  // set once a calculation has failed
+  int failed = 0;
+
+  // every calculation gets the threads_per_scc chosen by the scheduler
+  int outer, inner;
+  schedule_threads( settings, N_total, outer, inner );
+  GlobalSettings scc_settings = settings;
+  scc_settings.threads_per_scc = inner;
+#ifdef _OPENMP
+  // (engine 2 nests the sites inside the spins inside the calculations)
+  if ( inner > 1 ) {
+    omp_set_max_active_levels( 3 );
+  }
+#endif
+  Eigen::setNbThreads( inner );
+
+  if ( verbose ) {
+    cout << "Running " << outer << " calculation(s) concurrently with "
+         << inner << " thread(s) each" << endl;
+  }
+
+  // converged solutions are plotted by a background thread, so that the
+  // calculations don't wait for the disk and gnuplot
+  OutputQueue plots;
+  if ( settings.plotmode == 2 ) {
+    start_output( plots, settings, dir, outer );
+  }
+
+  // the ids are handed out dynamically to the threads of all processes, the
+  // continuations first: once they are all taken, a process stopped by the
+  // adaptive stopping takes no more ids from the counter and leaves the
+  // remaining restarts to the processes that have not stopped yet
+  TaskCounter counter;
+  open_task_counter( counter );
+  const int N_starts = starts.size();
+  int restarts_reached = 0;
+  int restarts_taken = 0;
+
+  #pragma omp parallel shared(some_gsc_found, gs_candidate, workspaces, \
+                              bound, local_stats, stop, failed, counter, \
+                              restarts_reached, restarts_taken, store, \
+                              plots) \
+                       firstprivate(scc_settings, dir) num_threads(outer)
+  while ( true ) {
+
+    int stop_now, reached_now;
+    #pragma omp atomic read
+    stop_now = stop;
+    #pragma omp atomic read
+    reached_now = restarts_reached;
+    if ( stop_now && reached_now ) {
+      break;
+    }
+
+    const int task = next_task( counter );
+    if ( task >= N_total ) {
+      break;
+    }
+    const int id = ( task < N_starts ) ? scc_settings.N_SCC + task
+                                       : task - N_starts;
+    if ( id < scc_settings.N_SCC ) {
+      #pragma omp atomic write
+      restarts_reached = 1;
+      #pragma omp atomic
+      ++restarts_taken;
+    }
+
+    int failed_now;
+    #pragma omp atomic read
+    failed_now = failed;
+    if ( failed_now ) {
+      continue;
+    }
+
+    // (the continuations are always run, a restart taken just before the
+    //  stop is skipped)
+    #pragma omp atomic read
+    stop_now = stop;
+    if ( stop_now && id < scc_settings.N_SCC ) {
+      #pragma omp atomic
+      ++local_stats.skipped;
+      continue;
+    }
+
+    // (--only_scc repeats a single calculation of a run in isolation)
+    if ( scc_settings.only_scc >= 0 && id != scc_settings.only_scc ) {
+      continue;
+    }
+
+#ifdef _OPENMP
+    SCCWorkspace& workspace = workspaces[omp_get_thread_num()];
+#else
+    SCCWorkspace& workspace = workspaces[0];
+#endif
+
+    if ( verbose ) {
+      #pragma omp critical (output)
+      {
+        cout << id << ": Calculation started";
+        if ( scc_settings.init == 3 && id < scc_settings.N_SCC
+             && seed_pattern( scc_settings, id ) >= 0 ) {
+          cout << " from "
+               << seed_patterns[seed_pattern( scc_settings, id )].name;
+        }
+        cout << "!" << endl;
+      }
+    }
+
+    // calculations finished before an interruption are only read back
+    SCCResults results;
+    if ( scc_settings.resume &&
+         read_finished( scc_settings, id, results ) == 0 ) {
+      if ( verbose ) {
+        #pragma omp critical (output)
+        { cout << id << ": Calculation already finished before!" << endl; }
+      }
+    } else {
+      SCCResults fresh =
+        run_scc( scc_settings, id,
+                 id < scc_settings.N_SCC ? NULL : starts[id - scc_settings.N_SCC],
+                 &workspace, &bound );
+      results.swap( fresh );
+
+      // (stored before it is recorded as finished, so that a resumed run
+      //  never misses it)
+      if ( results.exit_code == 0 && store != NULL ) {
+        int status;
+        #pragma omp critical (store)
+        status = append_record( *store, scc_settings, store_calculation, id,
+                                results );
+        if ( status != 0 ) {
+          #pragma omp critical (output)
+          { cerr << id << ": WARNING -> unable to store the results!" << endl; }
+        }
+      }
+
+      if ( results.exit_code == 0 && !scc_settings.checkpoint_prefix.empty()
+           && write_finished( scc_settings, id, results ) != 0 ) {
+        #pragma omp critical (output)
+        { cerr << id << ": WARNING -> unable to record the results!" << endl; }
+      }
+    }
+
+    if ( results.exit_code != 0 ) {
+      // (no more calculations are started, the whole run has failed)
+      #pragma omp critical (output)
+      { cerr << id << ": Calculation failed!" << endl; }
+      #pragma omp atomic write
+      failed = 1;
+    } else {
+      if ( verbose ) {
+        #pragma omp critical (output)
+        { cout << id << ": Calculation finished!" << endl; }
+      }
+      if ( results.pruned ) {
+        #pragma omp atomic
+        ++local_stats.pruned;
+        if ( verbose ) {
+          #pragma omp critical (output)
+          {
+            cout << id << ": Calculation pruned after "
+                 << results.iterations_to_convergence << " iterations!"
+                 << endl;
+          }
+        }
+      } else if ( !results.converged ) {
+        if ( verbose ) {
+          #pragma omp critical (output)
+          { cout << id << ": Calculation did not converge!" << endl; }
+        }
+      } else {
+        if ( verbose ) {
+          #pragma omp critical (output)
+          {
+            cout << id << ": Calculation converged!" << endl;
+
+            // output simulation results
+            cout << id << ": iterations_to_convergence = "
+                       << results.iterations_to_convergence << endl;
+            cout << id << ": Delta_n_up = " << results.Delta_n_up << endl;
+            cout << id << ": Delta_n_down = " << results.Delta_n_down << endl;
+            cout << id << ": energy = " << results.energy << endl;
+            cout << id << ": gap = " << results.gap << endl;
+            cout << id << ": m_z = " << results.m_z << endl;
+            if ( scc_settings.engine == 3 ) {
+              cout << id << ": m_spiral = " << results.m_spiral << endl;
+            }
+            cout << id << ": filling = " << results.filling << endl;
+          }
+        }
+
+        if ( scc_settings.plotmode == 2 ) {
+          queue_plot( plots, id, results );
+        }
+
+        #pragma omp critical (gsupdate)
+        {
+          // sort the solution into its basin and stop starting calculations
+          // once the lowest basin has been found often enough
+          vector<Basin>& basins = local_stats.basins;
+          const int b = add_to_basins( basins, results, scc_settings.s,
+                                       scc_settings.basin_tolerance );
+          if ( verbose ) {
+            #pragma omp critical (output)
+            { cout << id << ": Solution belongs to basin " << b << endl; }
+          }
+          if ( scc_settings.adaptive_hits > 0 &&
+               basins[lowest_basin( basins )].hits
+               >= scc_settings.adaptive_hits ) {
+            #pragma omp atomic write
+            stop = 1;
+          }
+
+          // check if this is an improvement over our best estimate of the gs
+          if ( !some_gsc_found ||
+               ( some_gsc_found && results.energy < gs_candidate.energy ) ) {
+            if ( verbose ) {
+              #pragma omp critical (output)
+              { cout << id << ": Best estimate of the ground state!" << endl; }
+            }
+            some_gsc_found = true;
+            // (results are moved, they are not needed anymore)
+            gs_candidate.swap( results );
+            #pragma omp atomic write
+            bound.energy = gs_candidate.energy;
+          }
+        }
+      }
+    }
+  }
+
+  close_task_counter( counter );
+
+  if ( settings.plotmode == 2 && finish_output( plots ) != 0 ) {
+    cerr << "ERROR while plotting the results!" << endl;
+  }
+
+  // write the iterations traced by all threads
+  if ( settings.trace != 0 ) {
+    vector<TraceEvent> events;
+    for ( size_t i = 0; i < workspaces.size(); ++i ) {
+      events.insert( events.end(), workspaces[i].trace.begin(),
+                     workspaces[i].trace.end() );
+      workspaces[i].trace.clear();
+    }
+    TraceSummary summary;
+    if ( write_trace( process_file( dir, "trace", ".dat" ), settings, events,
+                      summary ) != 0 ) {
+      cerr << "WARNING: unable to write the trace file!" << endl;
+    }
+    summary.calculations = mpi_sum( summary.calculations );
+    summary.iterations = mpi_sum( summary.iterations );
+    summary.solve = mpi_sum( summary.solve );
+    summary.density = mpi_sum( summary.density );
+    summary.mix = mpi_sum( summary.mix );
+    summary.other = mpi_sum( summary.other );
+    if ( verbose && mpi_rank() == 0 ) {
+      print_trace_summary( summary );
+    }
+  }
+
+  // a failed calculation fails the run on all processes
+  if ( !mpi_all( failed == 0 ) ) {
+    return 2;
+  }
+
+  // collect the results of all processes
+  mpi_best_results( some_gsc_found, gs_candidate );
+  local_stats.pruned = mpi_sum( local_stats.pruned );
+  // (the restarts no process has taken are skipped too)
+  local_stats.skipped = mpi_sum( local_stats.skipped )
+                        + settings.N_SCC - mpi_sum( restarts_taken );
+  mpi_gather_basins( local_stats.basins, settings.s, settings.basin_tolerance );
+
+  if ( verbose && mpi_rank() == 0 ) {
+    const vector<Basin>& basins = local_stats.basins;
+    cout << basins.size() << " distinct solution(s) found";
+    if ( !basins.empty() ) {
+      cout << ", the lowest one " << basins[lowest_basin( basins )].hits
+           << " time(s)";
+    }
+    cout << endl;
+    if ( settings.prune != 0 ) {
+      cout << local_stats.pruned << " of " << N_total
+           << " calculations pruned" << endl;
+    }
+    if ( settings.adaptive_hits > 0 ) {
+      cout << local_stats.skipped << " of " << N_total
+           << " calculations skipped" << endl;
+    }
+  }
+  if ( stats != NULL ) {
+    stats->pruned = local_stats.pruned;
+    stats->skipped = local_stats.skipped;
+    stats->basins.swap( local_stats.basins );
+  }
+
+  return some_gsc_found ? 0 : 1;
+}
+
+int run_sweep( const GlobalSettings& settings )
+{
+  // find the ground state on the (t_prime,U) grid, where every grid point is
+  // also continued from the ground states of its neighbours at the previous
+  // t_prime and U
+
+  const vector<fptype> t_primes = settings.sweep_t_prime.empty()
+                                  ? vector<fptype>( 1, settings.t_prime / settings.t )
+                                  : settings.sweep_t_prime;
+  const vector<fptype> Us = settings.sweep_U.empty()
+                            ? vector<fptype>( 1, settings.U / settings.t )
+                            : settings.sweep_U;
+
+  // prepare the output folder
+  string dir;
+  {
+    stringstream tmp;
+    tmp << setfill( '0' );
+    tmp << "sweep_s"          << settings.s
+        << "_t"  << setw( 5 ) << int( settings.t * 1000 );
+    dir = tmp.str();
+  }
+  // (only process 0 writes the ground states and the messages)
+  const bool master = ( mpi_rank() == 0 );
+  ResultsStore store;
+  bool ok = true;
+  if ( master ) {
+    if ( prepare_output_dir( dir, !settings.resume ) != 0 ) {
+      cerr << "ERROR: unable to clean/create the output directory!" << endl;
+      ok = false;
+    } else if ( open_results_store( settings, dir, store ) != 0 ) {
+      cerr << "ERROR: unable to open the results store?" << endl;
+      ok = false;
+    }
+  }
+  if ( !mpi_all( ok ) ) {
+    return 1;
+  }
+
+  // (plots are only made in the single point mode, and the continuation only
+  //  needs the mean field parameters)
+  GlobalSettings point = settings;
+  point.plotmode = 0;
+  point.keep_eigenvectors = 0;
+
+  // (checkpoints are written to files with a prefix per grid point)
+  const bool checkpointing = ( settings.checkpoint > 0 || settings.resume );
+
+  // the tight-binding part is shared by all points with the same t_prime
+  vector<SCCWorkspace> workspaces( max_threads( settings ) );
+
+  // ground states of all grid points (index i_tp * Us.size() + i_U)
+  vector<SCCResults> gs( t_primes.size() * Us.size() );
+  vector<bool> gs_found( gs.size(), false );
+
+  for ( size_t i_tp = 0; i_tp < t_primes.size(); ++i_tp ) {
+    for ( size_t i_U = 0; i_U < Us.size(); ++i_U ) {
+      const size_t k = i_tp * Us.size() + i_U;
+
+      point.t_prime = t_primes[i_tp] * settings.t;
+      point.U = Us[i_U] * settings.t;
+
+      // continue from the neighbouring ground states
+      vector<const SCCResults*> starts;
+      if ( i_U > 0 && gs_found[k - 1] ) {
+        starts.push_back( &gs[k - 1] );
+      }
+      if ( i_tp > 0 && gs_found[k - Us.size()] ) {
+        starts.push_back( &gs[k - Us.size()] );
+      }
+
+      // the checkpoints of a point are kept until its ground state is
+      // recorded, points recorded before an interruption are read back
+      stringstream prefix;
+      prefix << "./" << dir << "/point" << k << "_";
+      point.checkpoint_prefix = checkpointing ? prefix.str() : "";
+      GlobalSettings point_gs = point;
+      point_gs.checkpoint_prefix = "./" + dir + "/gs_";
+
+      RestartStats stats;
+      const bool read_back =
+        settings.resume && read_finished( point_gs, k, gs[k] ) == 0;
+      if ( read_back ) {
+        gs_found[k] = true;
+      } else {
+        const int status = run_restarts( point, dir, starts, workspaces,
+                                         false, gs[k], &stats );
+        if ( status == 2 ) {
+          return 1;
+        }
+        gs_found[k] = ( status == 0 );
+        // (points without a converged calculation are stored as well)
+        if ( master && append_record( store, point, store_ground_state, k,
+                                      gs[k] ) != 0 ) {
+          cerr << k << ": WARNING -> unable to store the ground state!" << endl;
+        }
+        if ( checkpointing && master ) {
+          if ( gs_found[k] ) {
+            write_finished( point_gs, k, gs[k] );
+          }
+          remove_checkpoints( point, settings.N_SCC + starts.size() );
+        }
+      }
+
+      if ( !master ) {
+        continue;
+      }
+
+      cout << "t_prime = " << point.t_prime << ", U = " << point.U << ": "
+           << ( gs_found[k] ? "energy = " : "no converged calculation!" );
+      if ( gs_found[k] ) {
+        cout << gs[k].energy;
+      }
+      if ( read_back ) {
+        cout << " (read back)";
+      } else {
+        cout << " (" << stats.basins.size() << " basins";
+        if ( settings.prune != 0 ) {
+          cout << ", " << stats.pruned << " pruned";
+        }
+        if ( settings.adaptive_hits > 0 ) {
+          cout << ", " << stats.skipped << " skipped";
+        }
+        cout << ")";
+      }
+      cout << endl;
+    }
+  }
+
+  if ( master ) {
+    close_store( store );
+    if ( checkpointing ) {
+      GlobalSettings point_gs = settings;
+      point_gs.checkpoint_prefix = "./" + dir + "/gs_";
+      remove_checkpoints( point_gs, gs.size() );
+    }
+    cout << endl << "Sweep finished, results written to "
+         << dir << "/results.mfr" << endl;
+  }
+
+  return 0;
+}
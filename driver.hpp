@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#ifndef __DRIVER_H_INCLUDED__
+#define __DRIVER_H_INCLUDED__
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <limits>
+#include <cmath>
+using namespace std;
+
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+
+#include "typedefs.hpp"
+#include "settings.hpp"
+#include "scc_inout.hpp"
+#include "scc_calc.hpp"
+#include "plot.hpp"
+#include "output.hpp"
+#include "basins.hpp"
+#include "distributed.hpp"
+#include "results_store.hpp"
+#include "trace.hpp"
+
+
+// what happened to the calculations of run_restarts
+struct RestartStats {
+  int pruned;  // aborted by the pruning
+  int skipped; // not started because of the adaptive stopping
+
+  // distinct converged solutions
+  vector<Basin> basins;
+
+  RestartStats() : pruned( 0 ), skipped( 0 ) { }
+};
+
+
+int prepare_output_dir( const string& dir, const bool& clean );
+
+int open_results_store( const GlobalSettings& settings, const string& dir,
+                        ResultsStore& store );
+
+// returns 0 if a converged ground state candidate was found, 1 if not and
+// 2 if a calculation failed
+int run_restarts( const GlobalSettings& settings, const string& dir,
+                  const vector<const SCCResults*>& starts,
+                  vector<SCCWorkspace>& workspaces, const bool& verbose,
+                  SCCResults& gs_candidate, RestartStats* stats = NULL,
+                  ResultsStore* store = NULL );
+
+int run_sweep( const GlobalSettings& settings );
+
+int max_threads( const GlobalSettings& settings );
+
+void schedule_threads( const GlobalSettings& settings, const int& N_total,
+                       int& outer, int& inner );
+
+#endif //__DRIVER_H_INCLUDED__
@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "eigensolver.hpp"
+
+#ifdef _LAPACK
+extern "C" {
+  void ssyevd_( const char* jobz, const char* uplo, const int* n, float* a,
+                const int* lda, float* w, float* work, const int* lwork,
+                int* iwork, const int* liwork, int* info );
+  void dsyevd_( const char* jobz, const char* uplo, const int* n, double* a,
+                const int* lda, double* w, double* work, const int* lwork,
+                int* iwork, const int* liwork, int* info );
+  void ssyevr_( const char* jobz, const char* range, const char* uplo,
+                const int* n, float* a, const int* lda, const float* vl,
+                const float* vu, const int* il, const int* iu,
+                const float* abstol, int* m, float* w, float* z,
+                const int* ldz, int* isuppz, float* work, const int* lwork,
+                int* iwork, const int* liwork, int* info );
+  void dsyevr_( const char* jobz, const char* range, const char* uplo,
+                const int* n, double* a, const int* lda, const double* vl,
+                const double* vu, const int* il, const int* iu,
+                const double* abstol, int* m, double* w, double* z,
+                const int* ldz, int* isuppz, double* work, const int* lwork,
+                int* iwork, const int* liwork, int* info );
+}
+
+// overloads picking the LAPACK routine matching the precision
+
+static inline void lapack_syevd( const int* n, float* a, float* w,
+                                 float* work, const int* lwork,
+                                 int* iwork, const int* liwork, int* info )
+{
+  ssyevd_( "V", "L", n, a, n, w, work, lwork, iwork, liwork, info );
+}
+
+static inline void lapack_syevd( const int* n, double* a, double* w,
+                                 double* work, const int* lwork,
+                                 int* iwork, const int* liwork, int* info )
+{
+  dsyevd_( "V", "L", n, a, n, w, work, lwork, iwork, liwork, info );
+}
+
+static inline void lapack_syevr( const int* n, float* a, const int* iu,
+                                 int* m, float* w, float* z, int* isuppz,
+                                 float* work, const int* lwork,
+                                 int* iwork, const int* liwork, int* info )
+{
+  const float zero = 0.0;
+  const int one = 1;
+  ssyevr_( "V", "I", "L", n, a, n, &zero, &zero, &one, iu, &zero, m, w, z, n,
+           isuppz, work, lwork, iwork, liwork, info );
+}
+
+static inline void lapack_syevr( const int* n, double* a, const int* iu,
+                                 int* m, double* w, double* z, int* isuppz,
+                                 double* work, const int* lwork,
+                                 int* iwork, const int* liwork, int* info )
+{
+  const double zero = 0.0;
+  const int one = 1;
+  dsyevr_( "V", "I", "L", n, a, n, &zero, &zero, &one, iu, &zero, m, w, z, n,
+           isuppz, work, lwork, iwork, liwork, info );
+}
+#endif
+
+bool diagonalizer_available( const int& backend )
+{
+#ifdef _LAPACK
+  return backend >= 0 && backend <= 2;
+#else
+  return backend == 0;
+#endif
+}
+
+bool diagonalizer_preserves( const int& backend )
+{
+  return backend == 0;
+}
+
+template <typename Scalar>
+int diagonalize( const int& backend, Matrix<Scalar, Dynamic, Dynamic>& H,
+                 const int& N_lowest,
+                 Array<Scalar, Dynamic, 1>& epsilon,
+                 Matrix<Scalar, Dynamic, Dynamic>& Q )
+{
+  // calculate the eigenvalues (ascending) and eigenvectors of H, at least the
+  // lowest N_lowest of them (only backend 2 calculates fewer than all)
+  // H is used as workspace and destroyed by the LAPACK backends
+
+  if ( backend == 0 ) {
+    SelfAdjointEigenSolver< Matrix<Scalar, Dynamic, Dynamic> > solver( H );
+    if ( solver.info() == NoConvergence ) {
+      return 1;
+    }
+    epsilon = solver.eigenvalues();
+    Q = solver.eigenvectors();
+    return 0;
+  }
+
+#ifdef _LAPACK
+  const int n = H.rows();
+  int info = 0;
+  Scalar work_query;
+  int iwork_query;
+  const int query = -1;
+  epsilon.resize( n );
+
+  if ( backend == 1 ) {
+
+    // workspace query, then the actual calculation in place of H
+    lapack_syevd( &n, H.data(), epsilon.data(), &work_query, &query,
+                  &iwork_query, &query, &info );
+    if ( info != 0 ) {
+      return 1;
+    }
+    const int lwork = static_cast<int>( work_query );
+    const int liwork = iwork_query;
+    vector<Scalar> work( lwork );
+    vector<int> iwork( liwork );
+    lapack_syevd( &n, H.data(), epsilon.data(), &work[0], &lwork,
+                  &iwork[0], &liwork, &info );
+    if ( info != 0 ) {
+      return 1;
+    }
+    Q.swap( H );
+    return 0;
+
+  } else if ( backend == 2 ) {
+
+    const int iu = min( max( N_lowest, 1 ), n );
+    int m = 0;
+    Q.resize( n, iu );
+    vector<int> isuppz( 2 * iu );
+    lapack_syevr( &n, H.data(), &iu, &m, epsilon.data(), Q.data(),
+                  &isuppz[0], &work_query, &query, &iwork_query, &query,
+                  &info );
+    if ( info != 0 ) {
+      return 1;
+    }
+    const int lwork = static_cast<int>( work_query );
+    const int liwork = iwork_query;
+    vector<Scalar> work( lwork );
+    vector<int> iwork( liwork );
+    lapack_syevr( &n, H.data(), &iu, &m, epsilon.data(), Q.data(),
+                  &isuppz[0], &work[0], &lwork, &iwork[0], &liwork, &info );
+    if ( info != 0 || m != iu ) {
+      return 1;
+    }
+    epsilon.conservativeResize( iu );
+    return 0;
+
+  }
+#endif
+
+  return 1;
+}
+
+template int diagonalize( const int& backend,
+                          Matrix<float, Dynamic, Dynamic>& H,
+                          const int& N_lowest,
+                          Array<float, Dynamic, 1>& epsilon,
+                          Matrix<float, Dynamic, Dynamic>& Q );
+template int diagonalize( const int& backend,
+                          Matrix<double, Dynamic, Dynamic>& H,
+                          const int& N_lowest,
+                          Array<double, Dynamic, 1>& epsilon,
+                          Matrix<double, Dynamic, Dynamic>& Q );
+
+int subspace_iteration( const SparseMatrix<fptype>& H_tb,
+                        const Array<fptype, Dynamic, 1>& V,
+                        const int& degree,
+                        Array<fptype, Dynamic, 1>& epsilon,
+                        Matrix<fptype, Dynamic, Dynamic>& Q )
+{
+  // refine the lowest eigenpairs of H = H_tb + diag( V ) by one pass of
+  // Chebyshev filtered subspace iteration (Zhou & Saad), starting from the
+  // approximate eigenpairs of the previous call in epsilon and Q
+
+  const int m = Q.cols();
+
+  // upper bound of the spectrum from Gershgorin's theorem
+  fptype E_max = V.maxCoeff();
+  {
+    Array<fptype, Dynamic, 1> radius = Array<fptype, Dynamic, 1>::Zero( V.size() );
+    for ( int k = 0; k < H_tb.outerSize(); ++k ) {
+      for ( SparseMatrix<fptype>::InnerIterator it( H_tb, k ); it; ++it ) {
+        radius( it.row() ) += abs( it.value() );
+      }
+    }
+    E_max += radius.maxCoeff();
+  }
+
+  // damp the interval [E_cut,E_max] above the subspace, scaled such that the
+  // lowest state keeps its norm
+  const fptype E_cut = epsilon( m - 1 );
+  const fptype E_low = epsilon( 0 );
+  if ( !( E_cut < E_max ) ) {
+    return 1;
+  }
+  const fptype e = 0.5 * ( E_max - E_cut );
+  const fptype c = 0.5 * ( E_max + E_cut );
+  fptype sigma = e / ( E_low - c );
+  const fptype tau = 2.0 / sigma;
+
+  Matrix<fptype, Dynamic, Dynamic> Y;
+  Matrix<fptype, Dynamic, Dynamic> Y_new;
+  Y = ( sigma / e ) * ( H_tb * Q + V.matrix().asDiagonal() * Q - c * Q );
+  for ( int i = 2; i <= degree; ++i ) {
+    const fptype sigma_new = 1.0 / ( tau - sigma );
+    Y_new = ( 2.0 * sigma_new / e )
+            * ( H_tb * Y + V.matrix().asDiagonal() * Y - c * Y )
+            - ( sigma * sigma_new ) * Q;
+    Q.swap( Y );
+    Y.swap( Y_new );
+    sigma = sigma_new;
+  }
+
+  // orthonormalize the filtered subspace
+  HouseholderQR< Matrix<fptype, Dynamic, Dynamic> > qr( Y );
+  Q = qr.householderQ() * Matrix<fptype, Dynamic, Dynamic>::Identity( Y.rows(), m );
+
+  // Rayleigh-Ritz step within the subspace
+  Y = H_tb * Q + V.matrix().asDiagonal() * Q;
+  SelfAdjointEigenSolver< Matrix<fptype, Dynamic, Dynamic> >
+    solver( Q.transpose() * Y );
+  if ( solver.info() == NoConvergence ) {
+    return 1;
+  }
+  epsilon = solver.eigenvalues();
+  Q = Q * solver.eigenvectors();
+
+  return 0;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#ifndef __EIGENSOLVER_H_INCLUDED__
+#define __EIGENSOLVER_H_INCLUDED__
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Eigenvalues>
+#include <eigen3/Eigen/QR>
+#include <eigen3/Eigen/SparseCore>
+using namespace Eigen;
+
+#include "typedefs.hpp"
+
+
+// backends for the diagonalization of dense real symmetric matrices
+// 0: Eigen (Householder tridiagonalization + implicit QR)
+// 1: LAPACK ?syevd (divide and conquer)
+// 2: LAPACK ?syevr (MRRR, only the requested lowest states)
+// (instantiated for float and double, so that the mixed precision mode can
+//  diagonalize in single precision independent of fptype)
+template <typename Scalar>
+int diagonalize( const int& backend, Matrix<Scalar, Dynamic, Dynamic>& H,
+                 const int& N_lowest,
+                 Array<Scalar, Dynamic, 1>& epsilon,
+                 Matrix<Scalar, Dynamic, Dynamic>& Q );
+
+bool diagonalizer_available( const int& backend );
+
+// whether the backend leaves H intact (the LAPACK ones use it as workspace)
+bool diagonalizer_preserves( const int& backend );
+
+int subspace_iteration( const SparseMatrix<fptype>& H_tb,
+                        const Array<fptype, Dynamic, 1>& V,
+                        const int& degree,
+                        Array<fptype, Dynamic, 1>& epsilon,
+                        Matrix<fptype, Dynamic, Dynamic>& Q );
+
+#endif //__EIGENSOLVER_H_INCLUDED__
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <vector>
+using namespace std;
+
+#include <omp.h>
+
+#include "typedefs.hpp"
+#include "settings.hpp"
+#include "scc_calc.hpp"
+#include "eigensolver.hpp"
+
+
+int main( int argc, char* argv[] )
+{
+  // time the diagonalization backends for H_up at half filling with random
+  // mean field parameters for the lattice sizes given on the command line
+  // usage: ./eigensolver_bench [s ...]
+
+  vector<int> sizes;
+  for ( int i = 1; i < argc; ++i ) {
+    sizes.push_back( atoi( argv[i] ) );
+  }
+  if ( sizes.empty() ) {
+    sizes.push_back( 16 );
+    sizes.push_back( 24 );
+    sizes.push_back( 32 );
+    sizes.push_back( 40 );
+  }
+
+  const char* names[] = { "eigen", "syevd", "syevr" };
+
+  cout << "#  s  backend      time/s  max|eps-eps_eigen|" << endl;
+
+  for ( size_t i = 0; i < sizes.size(); ++i ) {
+    GlobalSettings settings = get_precompiled_settings();
+    settings.s = sizes[i];
+    settings.t_prime = 0.2 * settings.t;
+    const int N = settings.s * settings.s;
+
+    SCCWorkspace workspace;
+    prepare_workspace( settings, workspace );
+
+    Matrix<fptype, Dynamic, Dynamic> H_full = workspace.H_tb;
+    for ( int j = 0; j < N; ++j ) {
+      H_full( j, j ) += 4.0 * rand() / static_cast<fptype>( RAND_MAX );
+    }
+
+    // the occupied states plus the two above them, like the SCC needs
+    const int N_lowest = N / 2 + 2;
+    Array<fptype, Dynamic, 1> epsilon_ref;
+
+    for ( int backend = 0; backend <= 2; ++backend ) {
+      if ( !diagonalizer_available( backend ) ) {
+        continue;
+      }
+
+      Matrix<fptype, Dynamic, Dynamic> H = H_full;
+      Array<fptype, Dynamic, 1> epsilon;
+      Matrix<fptype, Dynamic, Dynamic> Q;
+      const double t_start = omp_get_wtime();
+      const int status = diagonalize( backend, H, N_lowest, epsilon, Q );
+      const double t_used = omp_get_wtime() - t_start;
+      if ( status != 0 ) {
+        cerr << "ERROR: backend " << names[backend] << " failed!" << endl;
+        return 1;
+      }
+
+      if ( backend == 0 ) {
+        epsilon_ref = epsilon;
+      }
+      const fptype deviation =
+        ( epsilon.head( N_lowest ) - epsilon_ref.head( N_lowest ) )
+        .abs().maxCoeff();
+
+      cout << setw( 4 ) << settings.s
+           << setw( 9 ) << names[backend]
+           << setw( 12 ) << setprecision( 4 ) << fixed << t_used
+           << setw( 20 ) << scientific << deviation << endl;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "fd_sampler.hpp"
+#include "scc_calc.hpp"
+
+// The occupations are independent Bernoulli variables conditioned on their
+// sum. Shifting the chemical potential only multiplies the probability of
+// every set of N_occ states by the same factor, so it is first moved to
+// where N_occ is the most likely sum. Then the distribution of the number
+// of occupied states is calculated for the ranges of states of a binary
+// tree and the occupations are drawn from the root down: a range holding k
+// electrons gives j of them to its left half with a probability
+// ~ P_left( j ) P_right( k - j ). The distributions of a range of m states
+// are only nonzero within a few sqrt( m ) of their mean once the negligible
+// tails are cut off, so building and sampling the tree takes O(N log N)
+// instead of the redraws until the sum happens to be N_occ.
+
+// distribution of the number of occupied states in a range of states
+// (probabilities of lo, lo+1, ... occupied states)
+struct CountDistribution {
+  int lo;
+  vector<double> p;
+  int hi() const { return lo + int( p.size() ) - 1; }
+};
+
+// probabilities below this fraction of the most likely count are dropped
+static const double tail_cutoff = 1e-20;
+
+static void convolve( const CountDistribution& a, const CountDistribution& b,
+                      CountDistribution& c )
+{
+  vector<double> p( a.p.size() + b.p.size() - 1, 0.0 );
+  for ( size_t i = 0; i < a.p.size(); ++i ) {
+    for ( size_t j = 0; j < b.p.size(); ++j ) {
+      p[i + j] += a.p[i] * b.p[j];
+    }
+  }
+
+  const double p_max = *max_element( p.begin(), p.end() );
+  size_t first = 0;
+  size_t last = p.size() - 1;
+  while ( p[first] < tail_cutoff * p_max ) {
+    ++first;
+  }
+  while ( p[last] < tail_cutoff * p_max ) {
+    --last;
+  }
+
+  // (normalized, so that nothing underflows higher up the tree)
+  double sum = 0.0;
+  for ( size_t k = first; k <= last; ++k ) {
+    sum += p[k];
+  }
+  c.lo = a.lo + b.lo + int( first );
+  c.p.resize( last - first + 1 );
+  for ( size_t k = first; k <= last; ++k ) {
+    c.p[k - first] = p[k] / sum;
+  }
+}
+
+static void build_tree( const vector<double>& f, const int& node,
+                        const int& first, const int& last,
+                        vector<CountDistribution>& tree )
+{
+  // distributions of the states first ... last - 1 and all their subranges
+  CountDistribution& d = tree[node];
+  if ( last - first == 1 ) {
+    if ( f[first] >= 1.0 ) {
+      d.lo = 1;
+      d.p.assign( 1, 1.0 );
+    } else if ( f[first] <= 0.0 ) {
+      d.lo = 0;
+      d.p.assign( 1, 1.0 );
+    } else {
+      d.lo = 0;
+      d.p.resize( 2 );
+      d.p[0] = 1.0 - f[first];
+      d.p[1] = f[first];
+    }
+    return;
+  }
+  const int middle = ( first + last ) / 2;
+  build_tree( f, 2 * node + 1, first, middle, tree );
+  build_tree( f, 2 * node + 2, middle, last, tree );
+  convolve( tree[2 * node + 1], tree[2 * node + 2], d );
+}
+
+static void draw_tree( const vector<CountDistribution>& tree, const int& node,
+                       const int& first, const int& last, const int& k,
+                       gsl_rng* rng, vector<bool>& occupied )
+{
+  // distribute k electrons to the states first ... last - 1
+  if ( last - first == 1 ) {
+    occupied[first] = ( k == 1 );
+    return;
+  }
+  const CountDistribution& a = tree[2 * node + 1];
+  const CountDistribution& b = tree[2 * node + 2];
+  const int j_min = max( a.lo, k - b.hi() );
+  const int j_max = min( a.hi(), k - b.lo );
+
+  double total = 0.0;
+  for ( int j = j_min; j <= j_max; ++j ) {
+    total += a.p[j - a.lo] * b.p[k - j - b.lo];
+  }
+  double u = gsl_rng_uniform( rng ) * total;
+  int j = j_min;
+  for ( ; j < j_max; ++j ) {
+    u -= a.p[j - a.lo] * b.p[k - j - b.lo];
+    if ( u < 0.0 ) {
+      break;
+    }
+  }
+
+  const int middle = ( first + last ) / 2;
+  draw_tree( tree, 2 * node + 1, first, middle, j, rng, occupied );
+  draw_tree( tree, 2 * node + 2, middle, last, k - j, rng, occupied );
+}
+
+// comparison of state indices by their energy
+struct FDOrder {
+  const Array<fptype, Dynamic, 1>& epsilon;
+  FDOrder( const Array<fptype, Dynamic, 1>& eps ) : epsilon( eps ) { }
+  bool operator()( const int& a, const int& b ) const {
+    return epsilon( a ) < epsilon( b );
+  }
+};
+
+static vector<bool> lowest_states( const Array<fptype, Dynamic, 1>& epsilon,
+                                   const int& N_occ )
+{
+  vector<int> order( epsilon.size() );
+  for ( int i = 0; i < epsilon.size(); ++i ) {
+    order[i] = i;
+  }
+  sort( order.begin(), order.end(), FDOrder( epsilon ) );
+  vector<bool> occupied( epsilon.size(), false );
+  for ( int i = 0; i < N_occ; ++i ) {
+    occupied[order[i]] = true;
+  }
+  return occupied;
+}
+
+vector<bool> draw_fd_occupations( const Array<fptype, Dynamic, 1>& epsilon,
+                                  const fptype& E_fermi, const fptype& kT,
+                                  const int& N_occ, gsl_rng* rng )
+{
+  const int N = epsilon.size();
+  if ( kT <= 0.0 || N_occ <= 0 || N_occ >= N ) {
+    return lowest_states( epsilon, max( 0, min( N_occ, N ) ) );
+  }
+
+  // chemical potential at which N_occ states are occupied on average
+  // (both spins of find_chemical_potential are the states given here)
+  fptype mu = E_fermi;
+  find_chemical_potential( 1, kT, epsilon, epsilon, 2 * N_occ, mu );
+  vector<double> f( N );
+  for ( int i = 0; i < N; ++i ) {
+    f[i] = fermifunc( epsilon( i ), mu, kT );
+  }
+
+  vector<CountDistribution> tree( 4 * N );
+  build_tree( f, 0, 0, N, tree );
+
+  // (N_occ can only be cut off for degenerate levels at mu and a tiny kT)
+  if ( N_occ < tree[0].lo || N_occ > tree[0].hi() ) {
+    return lowest_states( epsilon, N_occ );
+  }
+
+  vector<bool> occupied( N, false );
+  draw_tree( tree, 0, 0, N, N_occ, rng, occupied );
+  return occupied;
+}
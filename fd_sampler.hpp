@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __FD_SAMPLER_H_INCLUDED__
+#define __FD_SAMPLER_H_INCLUDED__
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+#include <eigen3/Eigen/Core>
+using namespace Eigen;
+
+#include <gsl/gsl_rng.h>
+
+#include "typedefs.hpp"
+
+
+// randomly occupy exactly N_occ of the states with the Fermi-Dirac
+// probabilities f( epsilon_i ) conditioned on the particle number, i.e.
+// P( occupied set S ) ~ prod_{i in S} exp( -( epsilon_i - E_fermi ) / kT )
+// for |S| = N_occ (kT = 0: the lowest N_occ states)
+vector<bool> draw_fd_occupations( const Array<fptype, Dynamic, 1>& epsilon,
+                                  const fptype& E_fermi, const fptype& kT,
+                                  const int& N_occ, gsl_rng* rng );
+
+#endif //__FD_SAMPLER_H_INCLUDED__
@@ -39,3 +39,53 @@ int idx2y( const int& i, const int& s )
   // calculate the y position from the index
   return i / s;
 }
+
+int get_magnetic_cell( const int& cell, const int& s, MagneticCell& mc )
+{
+  // look up the magnetic unit cell with the given number of sites
+  if ( cell == 1 ) {
+    mc.p = 1; mc.q = 0; mc.r = 1;
+  } else if ( cell == 2 ) {
+    mc.p = 2; mc.q = 1; mc.r = 1;
+  } else if ( cell == 3 ) {
+    mc.p = 3; mc.q = 1; mc.r = 1;
+  } else if ( cell == 4 ) {
+    mc.p = 2; mc.q = 0; mc.r = 2;
+  } else {
+    return 1;
+  }
+
+  if ( !cell_tiles( mc, s ) ) {
+    return 2;
+  }
+
+  return 0;
+}
+
+bool cell_tiles( const MagneticCell& mc, const int& s )
+{
+  // the periodic s*s lattice has to be tiled by the magnetic unit cell
+  return s % mc.p == 0 && s % mc.r == 0 && ( ( s / mc.r ) * mc.q ) % mc.p == 0;
+}
+
+int xy2sub( int x, int y, const MagneticCell& mc )
+{
+  // calculate the sublattice index of the xy position in the lattice
+  const int y_cell = ( ( y % mc.r ) + mc.r ) % mc.r;
+  const int m = ( y - y_cell ) / mc.r;
+  const int x_cell = ( ( ( x - m * mc.q ) % mc.p ) + mc.p ) % mc.p;
+  return y_cell * mc.p + x_cell;
+}
+
+vector<int> neighbour_table( const int& s )
+{
+  // calculate the indices of all neighbours (entry i * N_BONDS + bond)
+  vector<int> nb( s * s * N_BONDS );
+  for ( int i = 0; i < s * s; ++i ) {
+    for ( int b = 0; b < N_BONDS; ++b ) {
+      nb[i * N_BONDS + b] =
+        xy2idx( idx2x( i, s ) + bond_dx[b], idx2y( i, s ) + bond_dy[b], s );
+    }
+  }
+  return nb;
+}
@@ -21,11 +21,31 @@
 #ifndef __LATTICE_H_INCLUDED__
 #define __LATTICE_H_INCLUDED__
 
+#include <vector>
+using namespace std;
+
 #include "settings.hpp"
 
 
+// bond vectors of the triangular lattice: four nearest neighbour bonds (t)
+// followed by the two diagonal bonds (t_prime)
+const int N_BONDS = 6;
+const int bond_dx[N_BONDS] = { -1, +1, 0, 0, -1, +1 };
+const int bond_dy[N_BONDS] = { 0, 0, -1, +1, +1, -1 };
+
 int xy2idx( int x, int y, const int& s );
 int idx2x( const int& i, const int& s );
 int idx2y( const int& i, const int& s );
 
+// magnetic unit cell spanned by the lattice translations (p,0) and (q,r)
+struct MagneticCell {
+  int p, q, r;
+};
+
+int get_magnetic_cell( const int& cell, const int& s, MagneticCell& mc );
+bool cell_tiles( const MagneticCell& mc, const int& s );
+int xy2sub( int x, int y, const MagneticCell& mc );
+
+vector<int> neighbour_table( const int& s );
+
 #endif //__LATTICE_H_INCLUDED__
@@ -21,6 +21,8 @@
 #include <iostream>
 #include <string>
 #include <fstream>
+#include <ctime>
+#include <vector>
 using namespace std;
 
 #include "typedefs.hpp"
@@ -29,42 +31,106 @@ using namespace std;
 #include "scc_inout.hpp"
 #include "scc_calc.hpp"
 #include "plot.hpp"
+#include "results_store.hpp"
+#include "driver.hpp"
+#include "server.hpp"
 
 
-int main( int argc, char* argv[] )
+static int mfhub( int argc, char* argv[] )
 {
+  // only process 0 talks to the user and writes the results
+  const bool master = ( mpi_rank() == 0 );
+
+  // (in the server mode stdout only carries the results of the jobs)
+  bool serving = false;
+  for ( int i = 1; i < argc; ++i ) {
+    if ( string( argv[i] ).compare( 0, 7, "--serve" ) == 0 ) {
+      serving = true;
+    }
+  }
+  const bool verbose = master && !serving;
 
-  cout << "HUBBARD MODEL in MEAN FIELD APPROXIMATION" << endl;
-  cout << "-----------------------------------------" << endl << endl;
+  if ( verbose ) {
+    cout << "HUBBARD MODEL in MEAN FIELD APPROXIMATION" << endl;
+    cout << "-----------------------------------------" << endl << endl;
+  }
 
   // properly initialize Eigen for use with OMP
   Eigen::initParallel();
 
-  // initialize c's random number gen (used to generate seeds to the real rngs)
-  srand( time( NULL ) );
+  // separate the optional --name=value arguments from the positional ones
+  vector<string> args;
+  vector< pair<string, string> > options;
+  for ( int i = 1; i < argc; ++i ) {
+    const string arg = argv[i];
+    if ( arg.compare( 0, 2, "--" ) == 0 ) {
+      const size_t eq = arg.find( '=' );
+      if ( eq == string::npos ) {
+        options.push_back( make_pair( arg.substr( 2 ), string( "1" ) ) );
+      } else {
+        options.push_back( make_pair( arg.substr( 2, eq - 2 ),
+                                      arg.substr( eq + 1 ) ) );
+      }
+    } else {
+      args.push_back( arg );
+    }
+  }
 
   // load settings for the simulations ...
   GlobalSettings settings;
-  if ( argc != 11 ) {
-    cout << "Using precompiled simulation settings ..." << endl;
+  if ( args.size() != 10 ) {
+    if ( verbose ) {
+      cout << "Using precompiled simulation settings ..." << endl;
+    }
     settings = get_precompiled_settings();
   } else {
-    cout << "Reading the settings from the command line ..." << endl;
+    if ( verbose ) {
+      cout << "Reading the settings from the command line ..." << endl;
+    }
+    settings = get_precompiled_settings();
+
+    settings.s = atoi( args[0].c_str() );
+    settings.t = atof( args[1].c_str() );
+    settings.t_prime = atof( args[2].c_str() ) * settings.t;
+    settings.U = atof( args[3].c_str() ) * settings.t;
 
-    settings.s = atoi( argv[1] );
-    settings.t = atof( argv[2] );
-    settings.t_prime = atof( argv[3] ) * settings.t;
-    settings.U = atof( argv[4] ) * settings.t;
+    settings.N_SCC = atoi( args[4].c_str() );
 
-    settings.N_SCC = atoi( argv[5] );
+    settings.m_prec = atof( args[5].c_str() ) * settings.s * settings.s;
+    settings.max_iterations = atoi( args[6].c_str() );
 
-    settings.m_prec = atof( argv[6] ) * settings.s * settings.s;
-    settings.max_iterations = atoi( argv[7] );
-    
-    settings.init = atoi( argv[8] );
-    settings.kT = atof( argv[9] );
+    settings.init = atoi( args[7].c_str() );
+    settings.kT = atof( args[8].c_str() );
 
-    settings.plotmode = atoi( argv[10] );
+    settings.plotmode = atoi( args[9].c_str() );
+  }
+
+  // ... and override them with the optional arguments
+  for ( size_t i = 0; i < options.size(); ++i ) {
+    if ( set_option( settings, options[i].first, options[i].second ) != 0 ) {
+      cerr << "ERROR: unknown option --" << options[i].first << endl;
+      return 1;
+    }
+  }
+
+  // the calculations draw from random number streams keyed by the seed,
+  // which is printed so that the run can be repeated with --seed
+  if ( settings.seed == 0 ) {
+    settings.seed = time( NULL );
+  }
+  settings.seed = mpi_broadcast( settings.seed );
+  if ( verbose ) {
+    cout << "Random seed: " << settings.seed << endl;
+  }
+
+  // run the jobs sent to the server mode
+  if ( serving ) {
+    return run_server( settings );
+  }
+
+  // sweep over a (t_prime,U) grid if requested
+  if ( !settings.sweep_t_prime.empty() || !settings.sweep_U.empty() ) {
+    return run_sweep( settings );
   }
 
   // prepare the output folder
@@ -79,81 +145,44 @@ int main( int argc, char* argv[] )
     dir = tmp.str();
     tmp.str() = "";
   }
-  if ( system( ( "test -e " + dir + " && rm -r ./" + dir + "/*" ).c_str() ) != 0
-       && system( ( "test -e " + dir + " || mkdir " + dir ).c_str() ) != 0 ) {
+  bool ok = true;
+  if ( master && prepare_output_dir( dir, !settings.resume ) != 0 ) {
     cerr << "ERROR: unable to clean/create the output directory!" << endl;
+    ok = false;
+  }
+  if ( !mpi_all( ok ) ) {
     return 1;
   }
 
-  // "best" simulation results = ground state
-  bool some_gsc_found = false; // will be set to true as soon as
-                               // one calculation finishes converged ...
-  SCCResults gs_candidate;
-
-  // launch N_SCC independent calculations
-  #pragma omp parallel for shared(some_gsc_found, gs_candidate) \
-                           firstprivate(settings, dir) schedule(dynamic)
-  for ( int id = 0; id < settings.N_SCC; ++id ) {
+  // the results are written to a binary store as they come in
+  ResultsStore store;
+  if ( ( master || settings.store_all != 0 ) &&
+       open_results_store( settings, dir, store ) != 0 ) {
+    cerr << "ERROR: unable to open the results store?" << endl;
+    ok = false;
+  }
+  if ( !mpi_all( ok ) ) {
+    return 1;
+  }
 
-    #pragma omp critical (output)
-    { cout << id << ": Calculation started!" << endl; }
+  // checkpoints are written to the output folder
+  if ( settings.checkpoint > 0 || settings.resume ) {
+    settings.checkpoint_prefix = "./" + dir + "/checkpoint_";
+  }
 
-    SCCResults results = run_scc( settings, id );
+  // find the best estimate of the ground state from N_SCC calculations
+  SCCResults gs_candidate;
+  RestartStats stats;
+  vector<SCCWorkspace> workspaces( max_threads( settings ) );
+  if ( run_restarts( settings, dir, vector<const SCCResults*>(), workspaces,
+                     true, gs_candidate, &stats,
+                     settings.store_all != 0 ? &store : NULL ) == 2 ) {
+    return 1;
+  }
 
-    if ( results.exit_code != 0 ) {
-      #pragma omp critical (output)
-      { cout << id << ": Calculation failed!" << endl; }
-      exit( 1 );
-    } else {
-      #pragma omp critical (output)
-      { cout << id << ": Calculation finished!" << endl; }
-      if ( !results.converged ) {
-        #pragma omp critical (output)
-        { cout << id << ": Calculation did not converge!" << endl; }
-      } else {
-        #pragma omp critical (output)
-        {
-          cout << id << ": Calculation converged!" << endl;
-
-          // output simulation results
-          cout << id << ": iterations_to_convergence = "
-                     << results.iterations_to_convergence << endl;
-          cout << id << ": Delta_n_up = " << results.Delta_n_up << endl;
-          cout << id << ": Delta_n_down = " << results.Delta_n_down << endl;
-          cout << id << ": energy = " << results.energy << endl;
-          cout << id << ": gap = " << results.gap << endl;
-          cout << id << ": m_z = " << results.m_z << endl;
-          cout << id << ": filling = " << results.filling << endl;
-        }
-
-        #pragma omp critical (gsupdate)
-        {
-          // check if this is an improvement over our best estimate of the gs
-          if ( !some_gsc_found ||
-               ( some_gsc_found && results.energy < gs_candidate.energy ) ) {
-            #pragma omp critical (output)
-            { cout << id << ": Best estimate of the ground state!" << endl; }
-            some_gsc_found = true;
-            gs_candidate = results;
-          }
-        }
-
-        if ( settings.plotmode == 2 ) {
-          #pragma omp critical (output)
-          { cout << id << ": Plotting started!" << endl; }
-
-          if ( plot( settings, results, dir, id ) != 0 ) {
-            #pragma omp critical (output)
-            { cerr << id << ": ERROR while plotting the results!" << endl; }
-            exit( 1 );
-          }
-          #pragma omp critical (output)
-          {
-            cout << id << ": Plotting finished!" << endl;
-          }
-        }
-      }
-    }
+  if ( !master ) {
+    close_store( store );
+    return 0;
   }
 
   // show results on stdout
@@ -169,30 +198,44 @@ int main( int argc, char* argv[] )
   cout << "energy = " << gs_candidate.energy << endl;
   cout << "gap = " << gs_candidate.gap << endl;
   cout << "m_z = " << gs_candidate.m_z << endl;
+  if ( settings.engine == 3 ) {
+    cout << "m_spiral = " << gs_candidate.m_spiral << endl;
+  }
   cout << "filling = " << gs_candidate.filling << endl;
 
   // output results to file
 
-  cout << "Outputting results in machine readable form to results.log ..." << endl;
-  ofstream results_log( ( "./" + dir + "/results.log" ).c_str() );
-  if ( !results_log.is_open() ) {
-    cerr << "ERROR: unable to open results output file?" << endl;
+  cout << "Outputting results in machine readable form to results.mfr ..." << endl;
+  if ( append_record( store, settings, store_ground_state, -1, gs_candidate )
+       != 0 ) {
+    cerr << "ERROR: unable to write the results store?" << endl;
     return 1;
   }
-  results_log << setiosflags( ios::scientific );
-  results_log.setf( ios::showpos );
-  results_log.precision( numeric_limits<fptype>::digits10 + 1 );
+  close_store( store );
 
-  results_log        << settings.s
-              << ' ' << settings.t
-              << ' ' << settings.t_prime
-              << ' ' << settings.U
-              << ' ' << gs_candidate.energy
-              << ' ' << gs_candidate.gap
-              << ' ' << gs_candidate.m_z
-              << ' ' << gs_candidate.filling << endl;
+  cout << "Outputting the basins of the solutions to basins.log ..." << endl;
+  ofstream basins_log( ( "./" + dir + "/basins.log" ).c_str() );
+  if ( !basins_log.is_open() ) {
+    cerr << "ERROR: unable to open basins output file?" << endl;
+    return 1;
+  }
+  basins_log << setiosflags( ios::scientific );
+  basins_log.setf( ios::showpos );
+  basins_log.precision( numeric_limits<fptype>::digits10 + 1 );
+
+  // (one line per basin: energy, |m_z| and number of calculations)
+  for ( size_t b = 0; b < stats.basins.size(); ++b ) {
+    basins_log        << stats.basins[b].energy
+               << ' ' << abs( stats.basins[b].m_z )
+               << ' ' << stats.basins[b].hits << endl;
+  }
+
+  basins_log.close();
 
-  results_log.close();
+  // all results are safely written, the checkpoints are not needed anymore
+  if ( !settings.checkpoint_prefix.empty() ) {
+    remove_checkpoints( settings, settings.N_SCC );
+  }
 
   // plot the results
 
@@ -206,3 +249,24 @@ int main( int argc, char* argv[] )
 
   return 0;
 }
+
+int main( int argc, char* argv[] )
+{
+#ifdef _MPI
+  // (the threads of a process take turns in calling MPI)
+  int provided;
+  MPI_Init_thread( &argc, &argv, MPI_THREAD_SERIALIZED, &provided );
+  if ( provided < MPI_THREAD_SERIALIZED ) {
+    cerr << "ERROR: MPI does not support calls from several threads!" << endl;
+    MPI_Abort( MPI_COMM_WORLD, 1 );
+  }
+#endif
+
+  const int status = mfhub( argc, argv );
+
+#ifdef _MPI
+  MPI_Finalize();
+#endif
+
+  return status;
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <limits>
+using namespace std;
+
+#include "typedefs.hpp"
+#include "lattice.hpp"
+#include "results_store.hpp"
+
+
+int main( int argc, char* argv[] )
+{
+  // export results stores written by mfhub as CSV to stdout
+  // usage: ./mfr2csv [--sites|--eigenvalues] file.mfr [file.mfr ...]
+  // default: one line with the scalars of every record
+  // --sites: one line with the mean field parameters of every site
+  // --eigenvalues: one line with the eigenvalues of every state
+
+  int mode = 0;
+  vector<string> files;
+  for ( int i = 1; i < argc; ++i ) {
+    const string arg = argv[i];
+    if ( arg == "--sites" ) {
+      mode = 1;
+    } else if ( arg == "--eigenvalues" ) {
+      mode = 2;
+    } else {
+      files.push_back( arg );
+    }
+  }
+  if ( files.empty() ) {
+    cerr << "usage: " << argv[0]
+         << " [--sites|--eigenvalues] file.mfr [file.mfr ...]" << endl;
+    return 1;
+  }
+
+  cout << setiosflags( ios::scientific );
+  cout.precision( numeric_limits<fptype>::digits10 + 1 );
+
+  if ( mode == 0 ) {
+    cout << "s,t,t_prime,U,energy,gap,m_z,filling,kind,id,converged,pruned,"
+            "iterations,Delta_n_up,Delta_n_down,spiral_qx,spiral_qy,m_spiral"
+         << endl;
+  } else if ( mode == 1 ) {
+    cout << "kind,id,site,x,y,n_up,n_down" << endl;
+  } else {
+    cout << "kind,id,state,epsilon_up,epsilon_down" << endl;
+  }
+
+  for ( size_t f = 0; f < files.size(); ++f ) {
+    MappedStore store;
+    if ( map_store( files[f], store ) != 0 ) {
+      cerr << "ERROR: " << files[f] << " is not a results store of this "
+              "version and floating point type!" << endl;
+      return 1;
+    }
+    const int s = store.header->s;
+
+    for ( size_t r = 0; r < store.N_records; ++r ) {
+      const StoreRecord& rec = store_record( store, r );
+
+      if ( mode == 0 ) {
+        cout        << s
+             << ',' << rec.t
+             << ',' << rec.t_prime
+             << ',' << rec.U
+             << ',' << rec.energy
+             << ',' << rec.gap
+             << ',' << rec.m_z
+             << ',' << rec.filling
+             << ',' << rec.kind
+             << ',' << rec.id
+             << ',' << rec.converged
+             << ',' << rec.pruned
+             << ',' << rec.iterations
+             << ',' << rec.Delta_n_up
+             << ',' << rec.Delta_n_down
+             << ',' << rec.spiral_qx
+             << ',' << rec.spiral_qy
+             << ',' << rec.m_spiral << '\n';
+      } else if ( mode == 1 ) {
+        const fptype* n_up = store_n_up( store, r );
+        const fptype* n_down = store_n_down( store, r );
+        for ( int i = 0; i < s * s; ++i ) {
+          cout        << rec.kind
+               << ',' << rec.id
+               << ',' << i
+               << ',' << idx2x( i, s )
+               << ',' << idx2y( i, s )
+               << ',' << n_up[i]
+               << ',' << n_down[i] << '\n';
+        }
+      } else {
+        const fptype* epsilon_up = store_epsilon_up( store, r );
+        const fptype* epsilon_down = store_epsilon_down( store, r );
+        for ( int i = 0; i < store.header->N_epsilon; ++i ) {
+          cout        << rec.kind
+               << ',' << rec.id
+               << ',' << i
+               << ',' << epsilon_up[i]
+               << ',' << epsilon_down[i] << '\n';
+        }
+      }
+    }
+
+    unmap_store( store );
+  }
+
+  return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "mixer.hpp"
+
+static void mixer_reset( MixerState& state )
+{
+  // forget the history (after a safeguard kicked in)
+  state.x_last.resize( 0 );
+  state.f_last.resize( 0 );
+  state.dx.clear();
+  state.df.clear();
+  state.u.clear();
+  state.v.clear();
+}
+
+static Array<fptype, Dynamic, 1> apply_inverse_jacobian(
+  const MixerState& state, const fptype& alpha,
+  const Array<fptype, Dynamic, 1>& y, const bool& transpose )
+{
+  // calculate H y (or H^T y) for H = -alpha + sum_i u_i v_i^T
+  Array<fptype, Dynamic, 1> Hy = -alpha * y;
+  for ( size_t i = 0; i < state.u.size(); ++i ) {
+    if ( transpose ) {
+      Hy += ( state.u[i] * y ).sum() * state.v[i];
+    } else {
+      Hy += ( state.v[i] * y ).sum() * state.u[i];
+    }
+  }
+  return Hy;
+}
+
+fptype mix_mean_fields( const GlobalSettings& settings, MixerState& state,
+                        gsl_rng* rng,
+                        Array<fptype, Dynamic, 1>& n_up,
+                        Array<fptype, Dynamic, 1>& n_down,
+                        const Array<fptype, Dynamic, 1>& n_up_new,
+                        const Array<fptype, Dynamic, 1>& n_down_new )
+{
+  // calculate the next input mean field parameters from the current input
+  // ( n_up, n_down ) and the resulting output ( n_up_new, n_down_new ),
+  // returns the effective mixing factor |x_next - x| / |f|
+
+  const int N = n_up.size();
+
+  if ( settings.mixer == 0 ) {
+    // linear mixing with a random factor in (0.25,0.75)
+    fptype mix = 0.5 * gsl_rng_uniform_pos( rng );
+
+    n_up   = ( 0.25 + mix ) * n_up_new   + ( 0.75 - mix ) * n_up;
+    n_down = ( 0.25 + mix ) * n_down_new + ( 0.75 - mix ) * n_down;
+    return 0.25 + mix;
+  }
+
+  fptype const& alpha = settings.mixing;
+
+  Array<fptype, Dynamic, 1> x( 2 * N );
+  Array<fptype, Dynamic, 1> f( 2 * N );
+  x << n_up, n_down;
+  f << n_up_new - n_up, n_down_new - n_down;
+
+  // safeguard: restart the history whenever the residual grew (the
+  // extrapolation otherwise tends to wander towards unstable fixed points)
+  if ( state.f_last.size() == f.size() &&
+       f.matrix().norm() > state.f_last.matrix().norm() ) {
+    mixer_reset( state );
+  }
+
+  // update the history
+  if ( state.x_last.size() == x.size() ) {
+    const Array<fptype, Dynamic, 1> dx = x - state.x_last;
+    const Array<fptype, Dynamic, 1> df = f - state.f_last;
+    if ( settings.mixer == 2 ) {
+      state.dx.push_back( dx );
+      state.df.push_back( df );
+    } else if ( settings.mixer == 3 ) {
+      // good Broyden update H += ( dx - H df ) dx^T H / ( dx^T H df )
+      const Array<fptype, Dynamic, 1> Htdx =
+        apply_inverse_jacobian( state, alpha, dx, true );
+      const fptype denominator = ( Htdx * df ).sum();
+      if ( abs( denominator ) > 1e-12 ) {
+        state.u.push_back(
+          ( dx - apply_inverse_jacobian( state, alpha, df, false ) )
+          / denominator );
+        state.v.push_back( Htdx );
+      }
+    }
+    while ( ( int ) state.dx.size() > settings.mixer_history ) {
+      state.dx.pop_front();
+      state.df.pop_front();
+    }
+    while ( ( int ) state.u.size() > settings.mixer_history ) {
+      state.u.pop_front();
+      state.v.pop_front();
+    }
+  }
+  state.x_last = x;
+  state.f_last = f;
+
+  // calculate the step
+  Array<fptype, Dynamic, 1> step;
+  if ( settings.mixer == 2 && !state.dx.empty() ) {
+    // Anderson/Pulay: minimize the linearized residual f - dF gamma within
+    // the history and mix linearly from there
+    const int m = state.dx.size();
+    Matrix<fptype, Dynamic, Dynamic> dX( 2 * N, m );
+    Matrix<fptype, Dynamic, Dynamic> dF( 2 * N, m );
+    for ( int i = 0; i < m; ++i ) {
+      dX.col( i ) = state.dx[i].matrix();
+      dF.col( i ) = state.df[i].matrix();
+    }
+    const Matrix<fptype, Dynamic, 1> gamma =
+      dF.cast<double>().colPivHouseholderQr()
+        .solve( f.matrix().cast<double>() ).cast<fptype>();
+    step = alpha * f - ( ( dX + alpha * dF ) * gamma ).array();
+  } else if ( settings.mixer == 3 ) {
+    // Broyden: quasi-Newton step with the approximate inverse Jacobian
+    step = -apply_inverse_jacobian( state, alpha, f, false );
+  } else {
+    // linear mixing with a fixed factor
+    step = alpha * f;
+  }
+
+  // safeguard: limit the largest change of a single mean field parameter
+  const fptype largest = step.abs().maxCoeff();
+  if ( settings.mixer_max_step > 0.0 && largest > settings.mixer_max_step ) {
+    step *= settings.mixer_max_step / largest;
+  }
+
+  // occupations have to stay physical
+  const Array<fptype, Dynamic, 1> x_next = ( x + step ).max( 0.0 ).min( 1.0 );
+  n_up = x_next.head( N );
+  n_down = x_next.tail( N );
+
+  const fptype f_norm = f.matrix().norm();
+  return f_norm > 0.0 ? ( x_next - x ).matrix().norm() / f_norm : 0.0;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#ifndef __MIXER_H_INCLUDED__
+#define __MIXER_H_INCLUDED__
+
+#include <algorithm>
+#include <deque>
+using namespace std;
+
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/QR>
+using namespace Eigen;
+
+#include <gsl/gsl_rng.h>
+
+#include "typedefs.hpp"
+#include "settings.hpp"
+
+
+// history of the mean field parameters x = ( n_up, n_down ) and their
+// residuals f = F( x ) - x of the previous iterations
+struct MixerState {
+  Array<fptype, Dynamic, 1> x_last;
+  Array<fptype, Dynamic, 1> f_last;
+
+  // Anderson: differences of x and f between subsequent iterations
+  deque< Array<fptype, Dynamic, 1> > dx;
+  deque< Array<fptype, Dynamic, 1> > df;
+
+  // Broyden: inverse Jacobian -alpha + sum_i u_i v_i^T
+  deque< Array<fptype, Dynamic, 1> > u;
+  deque< Array<fptype, Dynamic, 1> > v;
+};
+
+fptype mix_mean_fields( const GlobalSettings& settings, MixerState& state,
+                        gsl_rng* rng,
+                        Array<fptype, Dynamic, 1>& n_up,
+                        Array<fptype, Dynamic, 1>& n_down,
+                        const Array<fptype, Dynamic, 1>& n_up_new,
+                        const Array<fptype, Dynamic, 1>& n_down_new );
+
+#endif //__MIXER_H_INCLUDED__
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "output.hpp"
+
+#include <cerrno>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "plot.hpp"
+
+int make_dir( const string& dir )
+{
+  // create the directory unless it already exists
+  return ( mkdir( dir.c_str(), 0777 ) == 0 || errno == EEXIST ) ? 0 : 1;
+}
+
+static int remove_path( const string& path )
+{
+  // remove a file or a directory with everything in it
+  struct stat info;
+  if ( lstat( path.c_str(), &info ) != 0 ) {
+    return 1;
+  }
+  if ( S_ISDIR( info.st_mode ) ) {
+    if ( clean_dir( path ) != 0 ) {
+      return 1;
+    }
+    return rmdir( path.c_str() ) == 0 ? 0 : 1;
+  }
+  return unlink( path.c_str() ) == 0 ? 0 : 1;
+}
+
+int clean_dir( const string& dir )
+{
+  // remove everything in the directory, but keep the directory itself
+  DIR* handle = opendir( dir.c_str() );
+  if ( handle == NULL ) {
+    return 1;
+  }
+  int status = 0;
+  for ( dirent* entry = readdir( handle ); entry != NULL;
+        entry = readdir( handle ) ) {
+    const string name = entry->d_name;
+    if ( name != "." && name != ".." && remove_path( dir + "/" + name ) != 0 ) {
+      status = 1;
+    }
+  }
+  closedir( handle );
+  return status;
+}
+
+static int run_plot( const OutputQueue& queue, const PlotJob& job )
+{
+  #pragma omp critical (output)
+  { cout << job.id << ": Plotting started!" << endl; }
+
+  if ( plot( queue.settings, job.results, queue.dir, job.id ) != 0 ) {
+    #pragma omp critical (output)
+    { cerr << job.id << ": ERROR while plotting the results!" << endl; }
+    return 1;
+  }
+
+  #pragma omp critical (output)
+  { cout << job.id << ": Plotting finished!" << endl; }
+  return 0;
+}
+
+static void* output_thread( void* arg )
+{
+  OutputQueue& queue = *static_cast<OutputQueue*>( arg );
+
+  pthread_mutex_lock( &queue.mutex );
+  while ( true ) {
+    while ( queue.jobs.empty() && !queue.closing ) {
+      pthread_cond_wait( &queue.changed, &queue.mutex );
+    }
+    if ( queue.jobs.empty() ) {
+      break;
+    }
+    PlotJob* job = queue.jobs.front();
+    queue.jobs.pop_front();
+    pthread_cond_broadcast( &queue.changed );
+
+    // (the calculations can queue more results while this one is plotted)
+    pthread_mutex_unlock( &queue.mutex );
+    const int status = run_plot( queue, *job );
+    delete job;
+    pthread_mutex_lock( &queue.mutex );
+
+    queue.failed += status;
+  }
+  pthread_mutex_unlock( &queue.mutex );
+
+  return NULL;
+}
+
+int start_output( OutputQueue& queue, const GlobalSettings& settings,
+                  const string& dir, const size_t& capacity )
+{
+  queue.settings = settings;
+  queue.dir = dir;
+  queue.capacity = max( capacity, size_t( 1 ) );
+  queue.jobs.clear();
+  queue.closing = false;
+  queue.failed = 0;
+  pthread_mutex_init( &queue.mutex, NULL );
+  pthread_cond_init( &queue.changed, NULL );
+
+  // (without the thread the results are plotted right away)
+  queue.running =
+    ( pthread_create( &queue.thread, NULL, output_thread, &queue ) == 0 );
+  return queue.running ? 0 : 1;
+}
+
+void queue_plot( OutputQueue& queue, const int& id,
+                 const SCCResults& results )
+{
+  PlotJob* job = new PlotJob;
+  job->id = id;
+  job->results.n_up = results.n_up;
+  job->results.n_down = results.n_down;
+
+  if ( !queue.running ) {
+    const int status = run_plot( queue, *job );
+    delete job;
+    pthread_mutex_lock( &queue.mutex );
+    queue.failed += status;
+    pthread_mutex_unlock( &queue.mutex );
+    return;
+  }
+
+  // wait for a free place if the plots fall behind, so that the memory used
+  // by the waiting results stays bounded
+  pthread_mutex_lock( &queue.mutex );
+  while ( queue.jobs.size() >= queue.capacity ) {
+    pthread_cond_wait( &queue.changed, &queue.mutex );
+  }
+  queue.jobs.push_back( job );
+  pthread_cond_broadcast( &queue.changed );
+  pthread_mutex_unlock( &queue.mutex );
+}
+
+int finish_output( OutputQueue& queue )
+{
+  // wait until everything queued is plotted, returns the number of failures
+  if ( queue.running ) {
+    pthread_mutex_lock( &queue.mutex );
+    queue.closing = true;
+    pthread_cond_broadcast( &queue.changed );
+    pthread_mutex_unlock( &queue.mutex );
+    pthread_join( queue.thread, NULL );
+    queue.running = false;
+  }
+  pthread_cond_destroy( &queue.changed );
+  pthread_mutex_destroy( &queue.mutex );
+  return queue.failed;
+}
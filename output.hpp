@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __OUTPUT_H_INCLUDED__
+#define __OUTPUT_H_INCLUDED__
+
+#include <iostream>
+#include <string>
+#include <deque>
+using namespace std;
+
+#include <pthread.h>
+
+#include "typedefs.hpp"
+#include "settings.hpp"
+#include "scc_inout.hpp"
+
+
+// directories are created and cleaned in-process instead of by a shell
+int make_dir( const string& dir );
+int clean_dir( const string& dir );
+
+// results waiting to be plotted by the output thread
+struct PlotJob {
+  int id;
+  SCCResults results; // (only the mean field parameters)
+};
+
+// queue of results that a background thread writes and plots while the
+// calculations go on, at most capacity results are waiting at a time
+struct OutputQueue {
+  GlobalSettings settings;
+  string dir;
+  size_t capacity;
+
+  deque<PlotJob*> jobs;
+  bool running;
+  bool closing;
+  int failed;
+
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t changed;
+};
+
+int start_output( OutputQueue& queue, const GlobalSettings& settings,
+                  const string& dir, const size_t& capacity );
+void queue_plot( OutputQueue& queue, const int& id,
+                 const SCCResults& results );
+int finish_output( OutputQueue& queue );
+
+#endif //__OUTPUT_H_INCLUDED__
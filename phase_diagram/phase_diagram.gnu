@@ -16,6 +16,8 @@
 # along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
 
 
+set datafile separator ","
+
 set xlabel "U/t" 
 set ylabel "t'/t"
 
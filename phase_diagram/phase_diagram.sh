@@ -24,8 +24,9 @@ set -e
 # delete leftover files from former runs
 rm -rf $(ls . | grep -v phase_diagram)
 
-# link the mfhub executable
+# link the mfhub executable and the results store reader
 ln -s ../mfhub mfhub
+ln -s ../mfr2csv mfr2csv
 
 # constant parameters
 s=10;
@@ -37,21 +38,11 @@ max_iterations=100;
 init=2;
 kT=0.25;
 
-plotmode=1;
-
-# iterate over parameter space
-for t_prime in 0.00 0.05 0.10 0.15 0.20 0.25 0.30 0.35 0.40 0.45 0.50 \
-                    0.55 0.60 0.65 0.70 0.75 0.80 0.85 0.90 0.95 1.00
-do
-    for U in 0 0.1 0.2 0.4 0.6 0.8 1.0 1.25 1.5 1.75 2.0 2.5 3 4 5 6 8 10 12 14 16
-    do
-        ./mfhub $s $t $t_prime $U $N_SCC $m_prec $max_iterations $init $kT $plotmode
-    done
-done
-
-# collect results
-for dir in `ls -l | grep ^d | awk '{print $9}'`; do
-	cat ./$dir/results.log >> ./results.raw
-    echo >> ./results.raw
-done
-sed -e 's/inf/0.0000000e+00/g' results.raw | sed -e 's/nan/0.0000000e+00/g' > results.dat
+# iterate over parameter space in a single run, every point is also continued
+# from the ground states of its neighbours
+./mfhub $s $t 0 0 $N_SCC $m_prec $max_iterations $init $kT 0 \
+    --sweep_t_prime=0.00:0.05:1.00 \
+    --sweep_U=0,0.1,0.2,0.4,0.6,0.8,1.0,1.25,1.5,1.75,2.0,2.5,3,4,5,6,8,10,12,14,16
+
+# collect results (without the csv header line)
+./mfr2csv ./sweep_*/results.mfr | tail -n +2 > ./results.dat
@@ -20,6 +20,23 @@
 
 #include "plot.hpp"
 
+static int run_gnuplot( const string& dir )
+{
+  // run gnuplot on the script in dir directly, without a shell in between
+  const pid_t pid = fork();
+  if ( pid == 0 ) {
+    if ( chdir( dir.c_str() ) == 0 ) {
+      execlp( "gnuplot", "gnuplot", "plot.gnu", ( char* ) NULL );
+    }
+    _exit( 127 );
+  }
+  int status;
+  if ( pid < 0 || waitpid( pid, &status, 0 ) != pid ) {
+    return 1;
+  }
+  return ( WIFEXITED( status ) && WEXITSTATUS( status ) == 0 ) ? 0 : 1;
+}
+
 int plot( const GlobalSettings& settings, const SCCResults& results,
           const string& root_dir, int id )
 {
@@ -36,7 +53,7 @@ int plot( const GlobalSettings& settings, const SCCResults& results,
     tmp << setfill( '0' );
     tmp << "./" << root_dir << "/" << id << '/';
     dir = tmp.str();
-    if ( system( ( "test -e " + dir + " || mkdir " + dir ).c_str() ) != 0 ) {
+    if ( make_dir( dir ) != 0 ) {
       #pragma omp critical (output)
       { cerr << id << ": ERROR -> unable to create the output directory!"; }
       return 1;
@@ -101,8 +118,9 @@ int plot( const GlobalSettings& settings, const SCCResults& results,
 	splot 'n.log' using ($2+0.5*$3):3:5 notitle";
   gnuplot.close();
 
-  if ( system( ( "cd " + dir + " ; gnuplot plot.gnu" ).c_str() ) != 0 ) {
-    cerr << id << ": WARNING -> gnuplot call returned exit code != 0" << endl;
+  if ( run_gnuplot( dir ) != 0 ) {
+    #pragma omp critical (output)
+    { cerr << id << ": WARNING -> gnuplot call returned exit code != 0" << endl; }
   }
 
 #ifdef _VERBOSE
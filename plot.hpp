@@ -27,10 +27,14 @@
 #include <string>
 using namespace std;
 
+#include <unistd.h>
+#include <sys/wait.h>
+
 #include "typedefs.hpp"
 #include "settings.hpp"
 #include "lattice.hpp"
 #include "scc_inout.hpp"
+#include "output.hpp"
 
 
 int plot( const GlobalSettings& settings, const SCCResults& results,
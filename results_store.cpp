@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "results_store.hpp"
+
+#include <cstring>
+#include <limits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char magic[8] = { 'M', 'F', 'H', 'U', 'B', 'R', 'S', '2' };
+
+static StoreHeader make_header( const int& s, const int& N_epsilon )
+{
+  StoreHeader header;
+  memset( &header, 0, sizeof( header ) );
+  memcpy( header.magic, magic, sizeof( magic ) );
+  header.version = store_version;
+  header.fptype_size = sizeof( fptype );
+  header.s = s;
+  header.N_epsilon = N_epsilon;
+  header.record_size = sizeof( StoreRecord )
+                       + ( 2 * s * s + 2 * N_epsilon ) * sizeof( fptype );
+  return header;
+}
+
+static void put_column( fptype* column, const Array<fptype, Dynamic, 1>& a,
+                        const int& size )
+{
+  // (values that the engine did not calculate are stored as NaN)
+  const int n = min( int( a.size() ), size );
+  for ( int i = 0; i < n; ++i ) {
+    column[i] = a( i );
+  }
+  for ( int i = n; i < size; ++i ) {
+    column[i] = numeric_limits<fptype>::quiet_NaN();
+  }
+}
+
+int open_store( ResultsStore& store, const string& file, const int& s,
+                const int& N_epsilon, const bool& append )
+{
+  const StoreHeader header = make_header( s, N_epsilon );
+  store.s = s;
+  store.N_epsilon = N_epsilon;
+  store.record.assign( header.record_size, 0 );
+
+  if ( append ) {
+    // continue the store of an interrupted run, cutting off a record that
+    // was only partially written when it was killed
+    ifstream in( file.c_str(), ios::binary );
+    StoreHeader existing;
+    if ( in.read( reinterpret_cast<char*>( &existing ), sizeof( existing ) ) ) {
+      if ( memcmp( &existing, &header, sizeof( header ) ) != 0 ) {
+        return 1;
+      }
+      in.seekg( 0, ios::end );
+      const off_t size = in.tellg();
+      const off_t complete = sizeof( header )
+                             + ( size - off_t( sizeof( header ) ) )
+                               / header.record_size * header.record_size;
+      in.close();
+      if ( complete != size && truncate( file.c_str(), complete ) != 0 ) {
+        return 1;
+      }
+      store.file.open( file.c_str(), ios::binary | ios::app );
+      return store.file.is_open() ? 0 : 1;
+    }
+  }
+
+  store.file.open( file.c_str(), ios::binary | ios::trunc );
+  if ( !store.file.is_open() ) {
+    return 1;
+  }
+  store.file.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+  store.file.flush();
+  return store.file.good() ? 0 : 1;
+}
+
+int append_record( ResultsStore& store, const GlobalSettings& settings,
+                   const int& kind, const int& id, const SCCResults& results )
+{
+  StoreRecord* scalars = reinterpret_cast<StoreRecord*>( &store.record[0] );
+  scalars->kind = kind;
+  scalars->id = id;
+  scalars->converged = results.converged;
+  scalars->pruned = results.pruned;
+  scalars->iterations = results.iterations_to_convergence;
+  scalars->reserved = 0;
+  scalars->t = settings.t;
+  scalars->t_prime = settings.t_prime;
+  scalars->U = settings.U;
+  scalars->energy = results.energy;
+  scalars->gap = results.gap;
+  scalars->m_z = results.m_z;
+  scalars->filling = results.filling;
+  scalars->Delta_n_up = results.Delta_n_up;
+  scalars->Delta_n_down = results.Delta_n_down;
+  if ( settings.engine == 3 ) {
+    scalars->spiral_qx = settings.spiral_qx;
+    scalars->spiral_qy = settings.spiral_qy;
+    scalars->m_spiral = results.m_spiral;
+  } else {
+    scalars->spiral_qx = numeric_limits<fptype>::quiet_NaN();
+    scalars->spiral_qy = numeric_limits<fptype>::quiet_NaN();
+    scalars->m_spiral = numeric_limits<fptype>::quiet_NaN();
+  }
+
+  const int N = store.s * store.s;
+  fptype* columns = reinterpret_cast<fptype*>( scalars + 1 );
+  put_column( columns, results.n_up, N );
+  put_column( columns + N, results.n_down, N );
+  put_column( columns + 2 * N, results.epsilon_up, store.N_epsilon );
+  put_column( columns + 2 * N + store.N_epsilon, results.epsilon_down,
+              store.N_epsilon );
+
+  // (flushed, so that the record can be read while the run goes on)
+  store.file.write( &store.record[0], store.record.size() );
+  store.file.flush();
+  return store.file.good() ? 0 : 1;
+}
+
+void close_store( ResultsStore& store )
+{
+  if ( store.file.is_open() ) {
+    store.file.close();
+  }
+}
+
+int map_store( const string& file, MappedStore& store )
+{
+  store.map = NULL;
+  store.map_size = 0;
+
+  const int fd = open( file.c_str(), O_RDONLY );
+  if ( fd < 0 ) {
+    return 1;
+  }
+  struct stat info;
+  if ( fstat( fd, &info ) != 0 || size_t( info.st_size ) < sizeof( StoreHeader ) ) {
+    close( fd );
+    return 1;
+  }
+  void* map = mmap( NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+  close( fd );
+  if ( map == MAP_FAILED ) {
+    return 1;
+  }
+  store.map = map;
+  store.map_size = info.st_size;
+
+  // check that the records have the layout this program expects
+  store.header = static_cast<const StoreHeader*>( map );
+  const StoreHeader expected =
+    make_header( store.header->s, store.header->N_epsilon );
+  if ( memcmp( store.header, &expected, sizeof( expected ) ) != 0 ) {
+    unmap_store( store );
+    return 1;
+  }
+
+  // (a record that is still being written is not counted)
+  store.records = static_cast<const char*>( map ) + sizeof( StoreHeader );
+  store.N_records = ( store.map_size - sizeof( StoreHeader ) )
+                    / store.header->record_size;
+  return 0;
+}
+
+void unmap_store( MappedStore& store )
+{
+  if ( store.map != NULL ) {
+    munmap( store.map, store.map_size );
+    store.map = NULL;
+  }
+}
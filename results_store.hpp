@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __RESULTS_STORE_H_INCLUDED__
+#define __RESULTS_STORE_H_INCLUDED__
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstddef>
+using namespace std;
+
+#include "typedefs.hpp"
+#include "settings.hpp"
+#include "scc_inout.hpp"
+
+
+// The results store is a binary file made of a header followed by records of
+// a fixed size, so that records can be appended while a run is going on and a
+// reader can map the file into memory and index the records directly. Every
+// record starts with the scalars of one calculation, followed by the columns
+// n_up[s*s], n_down[s*s], epsilon_up[N_epsilon] and epsilon_down[N_epsilon]
+// (missing values are NaN). Numbers are stored with the byte order and the
+// fptype of the machine that wrote them.
+
+const int store_version = 2;
+
+struct StoreHeader {
+  char magic[8];
+  int version;
+  int fptype_size;
+  int s;
+  int N_epsilon;
+  int record_size;
+  int reserved[3];
+};
+
+// record kinds
+const int store_calculation = 0;
+const int store_ground_state = 1;
+
+struct StoreRecord {
+  int kind;
+  int id;
+  int converged;
+  int pruned;
+  int iterations;
+  int reserved;
+  fptype t, t_prime, U;
+  fptype energy, gap, m_z, filling;
+  fptype Delta_n_up, Delta_n_down;
+  // wave vector and in-plane moment of the spin spiral (engine 3)
+  fptype spiral_qx, spiral_qy, m_spiral;
+};
+
+// writing
+
+struct ResultsStore {
+  ofstream file;
+  int s;
+  int N_epsilon;
+  vector<char> record;
+};
+
+int open_store( ResultsStore& store, const string& file, const int& s,
+                const int& N_epsilon, const bool& append );
+int append_record( ResultsStore& store, const GlobalSettings& settings,
+                   const int& kind, const int& id, const SCCResults& results );
+void close_store( ResultsStore& store );
+
+// reading
+
+struct MappedStore {
+  const StoreHeader* header;
+  const char* records;
+  size_t N_records;
+  void* map;
+  size_t map_size;
+};
+
+int map_store( const string& file, MappedStore& store );
+void unmap_store( MappedStore& store );
+
+inline const StoreRecord& store_record( const MappedStore& store,
+                                        const size_t& i )
+{
+  return *reinterpret_cast<const StoreRecord*>(
+           store.records + i * store.header->record_size );
+}
+
+inline const fptype* store_n_up( const MappedStore& store, const size_t& i )
+{
+  return reinterpret_cast<const fptype*>( &store_record( store, i ) + 1 );
+}
+
+inline const fptype* store_n_down( const MappedStore& store, const size_t& i )
+{
+  return store_n_up( store, i ) + store.header->s * store.header->s;
+}
+
+inline const fptype* store_epsilon_up( const MappedStore& store,
+                                       const size_t& i )
+{
+  return store_n_down( store, i ) + store.header->s * store.header->s;
+}
+
+inline const fptype* store_epsilon_down( const MappedStore& store,
+                                         const size_t& i )
+{
+  return store_epsilon_up( store, i ) + store.header->N_epsilon;
+}
+
+#endif //__RESULTS_STORE_H_INCLUDED__
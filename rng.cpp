@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "rng.hpp"
+
+static void philox_block( const uint32_t key_in[2], const uint32_t counter[4],
+                          uint32_t out[4] )
+{
+  // ten rounds of Philox4x32 on the counter
+  uint32_t key[2] = { key_in[0], key_in[1] };
+  uint32_t x[4] = { counter[0], counter[1], counter[2], counter[3] };
+  for ( int round = 0; round < 10; ++round ) {
+    const uint64_t p0 = uint64_t( 0xD2511F53u ) * x[0];
+    const uint64_t p1 = uint64_t( 0xCD9E8D57u ) * x[2];
+    const uint32_t y[4] = {
+      uint32_t( p1 >> 32 ) ^ x[1] ^ key[0], uint32_t( p1 ),
+      uint32_t( p0 >> 32 ) ^ x[3] ^ key[1], uint32_t( p0 )
+    };
+    memcpy( x, y, sizeof( x ) );
+    key[0] += 0x9E3779B9u;
+    key[1] += 0xBB67AE85u;
+  }
+  memcpy( out, x, sizeof( x ) );
+}
+
+static void philox_set( void* vstate, unsigned long int seed )
+{
+  PhiloxState* state = static_cast<PhiloxState*>( vstate );
+  state->key[0] = uint32_t( seed );
+  state->key[1] = uint32_t( uint64_t( seed ) >> 32 );
+  memset( state->counter, 0, sizeof( state->counter ) );
+  state->used = 4;
+}
+
+static unsigned long int philox_get( void* vstate )
+{
+  PhiloxState* state = static_cast<PhiloxState*>( vstate );
+  if ( state->used == 4 ) {
+    philox_block( state->key, state->counter, state->output );
+    // (the position is a 64 bit counter)
+    if ( ++state->counter[0] == 0 ) {
+      ++state->counter[1];
+    }
+    state->used = 0;
+  }
+  return state->output[state->used++];
+}
+
+static double philox_get_double( void* vstate )
+{
+  return philox_get( vstate ) / 4294967296.0;
+}
+
+static const gsl_rng_type philox_type = {
+  "philox4x32", 0xffffffffUL, 0, sizeof( PhiloxState ),
+  &philox_set, &philox_get, &philox_get_double
+};
+
+const gsl_rng_type* rng_philox = &philox_type;
+
+static uint32_t point_key( const GlobalSettings& settings )
+{
+  // FNV-1a hash of the parameters of the point
+  const fptype parameters[3] = { settings.t, settings.t_prime, settings.U };
+  const unsigned char* bytes =
+    reinterpret_cast<const unsigned char*>( parameters );
+  uint32_t hash = 2166136261u;
+  for ( size_t i = 0; i < sizeof( parameters ); ++i ) {
+    hash = ( hash ^ bytes[i] ) * 16777619u;
+  }
+  return hash;
+}
+
+gsl_rng* alloc_scc_rng( const GlobalSettings& settings, const int& id )
+{
+  gsl_rng* rng = gsl_rng_alloc( rng_philox );
+  gsl_rng_set( rng, settings.seed );
+  PhiloxState* state = static_cast<PhiloxState*>( gsl_rng_state( rng ) );
+  state->counter[2] = uint32_t( id );
+  state->counter[3] = point_key( settings );
+  return rng;
+}
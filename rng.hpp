@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __RNG_H_INCLUDED__
+#define __RNG_H_INCLUDED__
+
+#include <cstring>
+#include <stdint.h>
+using namespace std;
+
+#include <gsl/gsl_rng.h>
+
+#include "typedefs.hpp"
+#include "settings.hpp"
+
+
+// counter based generator Philox4x32-10 (Salmon et al., SC11) as a GSL
+// generator type: the numbers are the encryption of a counter with a key,
+// so every ( key, counter[2..3] ) is an independent stream that needs no
+// state shared between the threads
+struct PhiloxState {
+  uint32_t key[2];
+  uint32_t counter[4];  // 0,1: position in the stream, 2,3: stream
+  uint32_t output[4];
+  int used;             // numbers of output already handed out
+};
+
+extern const gsl_rng_type* rng_philox;
+
+// the random number stream of calculation id: keyed by settings.seed and
+// selected by id and the parameters of the point, so that a calculation
+// draws the same numbers no matter which thread or process runs it and
+// whether it is run alone (--only_scc) or as part of a sweep
+gsl_rng* alloc_scc_rng( const GlobalSettings& settings, const int& id );
+
+#endif //__RNG_H_INCLUDED__
@@ -20,68 +20,332 @@
 
 #include "scc_calc.hpp"
 
-SCCResults run_scc( const GlobalSettings& settings, const int& id )
+
+template <typename Scalar>
+static int solve_spins( const int& diagonalizer,
+                        const Matrix<Scalar, Dynamic, Dynamic>& H_tb,
+                        const fptype& U,
+                        const Array<fptype, Dynamic, 1>& n_up,
+                        const Array<fptype, Dynamic, 1>& n_down,
+                        const int& N_lowest, const int& spin_threads,
+                        Matrix<Scalar, Dynamic, Dynamic>& H_up,
+                        Matrix<Scalar, Dynamic, Dynamic>& H_down,
+                        Array<Scalar, Dynamic, 1>& epsilon_up,
+                        Array<Scalar, Dynamic, 1>& epsilon_down,
+                        Matrix<Scalar, Dynamic, Dynamic>& Q_up,
+                        Matrix<Scalar, Dynamic, Dynamic>& Q_down )
+{
+  // construct H_up and H_down from the mean field parameters and
+  // diagonalize them concurrently in the precision Scalar
+  // (H_sigma still holds the hopping of the previous iteration unless the
+  //  diagonalizer used it as workspace, then only its diagonal is updated)
+
+  const bool intact = diagonalizer_preserves( diagonalizer );
+
+  // H_up == H_down if the mean field parameters of both spins agree (the
+  // paramagnetic start of init=2), then it is only diagonalized once
+  if ( ( n_up == n_down ).all() ) {
+    build_H_sigma( H_tb, U, n_down, H_up, intact );
+    const int status = diagonalize( diagonalizer, H_up, N_lowest,
+                                    epsilon_up, Q_up );
+    epsilon_down = epsilon_up;
+    Q_down = Q_up;
+    return status;
+  }
+
+  int status_up = 0, status_down = 0;
+  #pragma omp parallel sections num_threads( spin_threads )
+  {
+    #pragma omp section
+    {
+      build_H_sigma( H_tb, U, n_down, H_up, intact );
+      status_up = diagonalize( diagonalizer, H_up, N_lowest,
+                               epsilon_up, Q_up );
+    }
+    #pragma omp section
+    {
+      build_H_sigma( H_tb, U, n_up, H_down, intact );
+      status_down = diagonalize( diagonalizer, H_down, N_lowest,
+                                 epsilon_down, Q_down );
+    }
+  }
+  return ( status_up != 0 || status_down != 0 ) ? 1 : 0;
+}
+
+template <typename Scalar>
+static Array<fptype, Dynamic, 1> state_density(
+  const Matrix<Scalar, Dynamic, Dynamic>& Q, const vector<bool>& occupied )
+{
+  // density of the given eigenstates
+  Array<Scalar, Dynamic, 1> n = Array<Scalar, Dynamic, 1>::Zero( Q.rows() );
+  for ( int alpha = 0; alpha < Q.cols(); ++alpha ) {
+    if ( occupied[alpha] ) {
+      n += Q.col( alpha ).array().square();
+    }
+  }
+  return n.template cast<fptype>();
+}
+
+// H_up and H_down of run_scc_dense as matrices of any size and their
+// eigenpairs, in fptype and in single precision for the mixed precision mode
+struct DenseSpins {
+  const SCCWorkspace* workspace;
+  int diagonalizer;
+  int filter_degree;
+
+  // H_up == H_down in the last iteration
+  bool same;
+
+  Matrix<fptype, Dynamic, Dynamic> H_up, H_down;
+  Matrix<fptype, Dynamic, Dynamic> Q_up, Q_down;
+
+  Matrix<float, Dynamic, Dynamic> H_up_single, H_down_single;
+  Matrix<float, Dynamic, Dynamic> Q_up_single, Q_down_single;
+  Array<float, Dynamic, 1> epsilon_up_single, epsilon_down_single;
+
+  void prepare( const GlobalSettings& settings, SCCWorkspace& ws,
+                const bool& mixed )
+  {
+    if ( mixed && ws.H_tb_single.rows() != ws.H_tb.rows() ) {
+      ws.H_tb_single = ws.H_tb.cast<float>();
+    }
+    workspace = &ws;
+    diagonalizer = settings.diagonalizer;
+    filter_degree = settings.filter_degree;
+    same = false;
+  }
+
+  int solve( const bool& refine, const int& N_lowest, const bool& single,
+             const fptype& U,
+             const Array<fptype, Dynamic, 1>& n_up,
+             const Array<fptype, Dynamic, 1>& n_down,
+             const int& spin_threads,
+             Array<fptype, Dynamic, 1>& epsilon_up,
+             Array<fptype, Dynamic, 1>& epsilon_down )
+  {
+    // returns 1 if the diagonalization and 2 if the subspace iteration failed
+    same = ( n_up == n_down ).all();
+
+    if ( refine ) {
+      // keep only the starting subspace and refine the previous eigenpairs
+      if ( Q_up.cols() > N_lowest ) {
+        epsilon_up.conservativeResize( N_lowest );
+        epsilon_down.conservativeResize( N_lowest );
+        Q_up.conservativeResize( NoChange, N_lowest );
+        Q_down.conservativeResize( NoChange, N_lowest );
+      }
+      int status_up = 0, status_down = 0;
+      #pragma omp parallel sections num_threads( spin_threads )
+      {
+        #pragma omp section
+        {
+          status_up = subspace_iteration( workspace->H_tb_sparse, U * n_down,
+                                          filter_degree, epsilon_up, Q_up );
+        }
+        #pragma omp section
+        {
+          status_down = subspace_iteration( workspace->H_tb_sparse, U * n_up,
+                                            filter_degree, epsilon_down,
+                                            Q_down );
+        }
+      }
+      return ( status_up != 0 || status_down != 0 ) ? 2 : 0;
+    }
+
+    if ( single ) {
+      const int status =
+        solve_spins( diagonalizer, workspace->H_tb_single, U, n_up, n_down,
+                     N_lowest, spin_threads, H_up_single, H_down_single,
+                     epsilon_up_single, epsilon_down_single,
+                     Q_up_single, Q_down_single );
+      epsilon_up = epsilon_up_single.cast<fptype>();
+      epsilon_down = epsilon_down_single.cast<fptype>();
+      return status;
+    }
+    return solve_spins( diagonalizer, workspace->H_tb, U, n_up, n_down,
+                        N_lowest, spin_threads, H_up, H_down,
+                        epsilon_up, epsilon_down, Q_up, Q_down );
+  }
+
+  void density( const bool& single, const int& N_occ, const int& threads,
+                Array<fptype, Dynamic, 1>& n_up,
+                Array<fptype, Dynamic, 1>& n_down )
+  {
+    // (the eigenvectors of both spins are the same if H_up == H_down)
+    if ( single ) {
+      occupied_density( Q_up_single, same ? Q_up_single : Q_down_single,
+                        N_occ, threads, n_up, n_down );
+    } else {
+      occupied_density( Q_up, same ? Q_up : Q_down,
+                        N_occ, threads, n_up, n_down );
+    }
+  }
+
+  void smeared_density( const bool& single,
+                        const Array<fptype, Dynamic, 1>& w_up,
+                        const Array<fptype, Dynamic, 1>& w_down,
+                        const int& threads,
+                        Array<fptype, Dynamic, 1>& n_up,
+                        Array<fptype, Dynamic, 1>& n_down )
+  {
+    if ( single ) {
+      weighted_density( Q_up_single, Q_down_single, w_up, w_down,
+                        threads, n_up, n_down );
+    } else {
+      weighted_density( Q_up, Q_down, w_up, w_down, threads, n_up, n_down );
+    }
+  }
+
+  void drawn_density( const bool& single, const vector<bool>& occupied_up,
+                      const vector<bool>& occupied_down,
+                      Array<fptype, Dynamic, 1>& n_up,
+                      Array<fptype, Dynamic, 1>& n_down )
+  {
+    if ( single ) {
+      n_up = state_density( Q_up_single, occupied_up );
+      n_down = state_density( Q_down_single, occupied_down );
+    } else {
+      n_up = state_density( Q_up, occupied_up );
+      n_down = state_density( Q_down, occupied_down );
+    }
+  }
+
+  void eigenvectors( const bool& single,
+                     Matrix<fptype, Dynamic, Dynamic>& Q_up_out,
+                     Matrix<fptype, Dynamic, Dynamic>& Q_down_out )
+  {
+    // (handed over without copying them, they are 2*(s*s)^2 numbers)
+    if ( single ) {
+      Q_up_out = Q_up_single.cast<fptype>();
+      Q_down_out = Q_down_single.cast<fptype>();
+    } else {
+      Q_up_out.swap( Q_up );
+      Q_down_out.swap( Q_down );
+    }
+  }
+};
+
+SCCResults run_scc( const GlobalSettings& settings, const int& id,
+                    const SCCResults* start, SCCWorkspace* workspace,
+                    const SCCBound* bound )
 {
+  // the iterations are traced into the buffer of the workspace
+  vector<TraceEvent>* trace =
+    ( settings.trace != 0 && workspace != NULL ) ? &workspace->trace : NULL;
 
+  // (0: no smearing, 1: Fermi-Dirac, 2: Methfessel-Paxton)
+  if ( settings.smearing < 0 || settings.smearing > 2 ) {
+    #pragma omp critical (output)
+    { cerr << id << ": ERROR -> unknown smearing method!" << endl; }
+    return SCCResults();
+  }
+
+  // occupations other than the lowest half of the states of every spin are
+  // only implemented for the full diagonalization and the spin spirals
+  if ( settings.smearing == 0 && settings.filling != 0.5
+       && settings.engine != 3 ) {
+    #pragma omp critical (output)
+    { cerr << id << ": ERROR -> fillings other than 0.5 need --smearing!" << endl; }
+    return SCCResults();
+  }
+  if ( settings.smearing != 0 && settings.engine != 3
+       && ( settings.engine != 0 || settings.eigensolver != 0 ) ) {
+    #pragma omp critical (output)
+    {
+      cerr << id << ": ERROR -> smearing is only available for engine 0 "
+           << "with eigensolver 0 and engine 3!" << endl;
+    }
+    return SCCResults();
+  }
+
+  // hand the calculation over to the other engines if requested
+  if ( settings.engine == 1 ) {
+    return run_scc_kspace( settings, id, start, bound, trace );
+  } else if ( settings.engine == 2 ) {
+    return run_scc_kpm( settings, id, start, trace );
+  } else if ( settings.engine == 3 ) {
+    return run_scc_spiral( settings, id, start, bound, trace );
+  }
+
+  // the tight-binding part of H_sigma is kept in the workspace, so that it
+  // is only calculated once for all calculations of the same system
+  SCCWorkspace local_workspace;
+  if ( workspace == NULL ) {
+    workspace = &local_workspace;
+  }
+
+  if ( fixed_size_available( settings ) ) {
+    return run_scc_fixed( settings, id, start, *workspace, bound, trace );
+  }
+  DenseSpins spins;
+  return run_scc_dense( settings, id, start, *workspace, bound, trace, spins );
+}
+
+template <typename Spins>
+SCCResults run_scc_dense( const GlobalSettings& settings, const int& id,
+                          const SCCResults* start, SCCWorkspace& workspace,
+                          const SCCBound* bound, vector<TraceEvent>* trace,
+                          Spins& spins )
+{
   // ----- INITIALIZATION -----
 
   SCCResults results;
 
   // define short names for the most used settings:
   int const& s = settings.s;
-  fptype const& t = settings.t;
-  fptype const& t_prime = settings.t_prime;
   fptype const& U = settings.U;
   fptype const& m_prec = settings.m_prec;
 
-  // create a new random number generator
-  gsl_rng* rng;
-  rng = gsl_rng_alloc( gsl_rng_mt19937 );
-  gsl_rng_set( rng, rand() );
+  if ( !diagonalizer_available( settings.diagonalizer ) ) {
+    #pragma omp critical (output)
+    { cerr << id << ": ERROR -> diagonalizer not available!" << endl; }
+    return results;
+  }
+
+  // occupations smeared around the chemical potential mu instead of the
+  // lowest half of the states of every spin
+  const bool smeared = ( settings.smearing != 0 );
+
+  // the Fermi-Dirac start of init=2 is skipped when continuing from a
+  // given solution (and not needed with smeared occupations)
+  const bool fd_start = ( settings.init == 2 && start == NULL && !smeared );
+
+  // create the random number stream of this calculation
+  gsl_rng* rng = alloc_scc_rng( settings, id );
 
   // initialize mean field parameter <n_i,sigma>
-  Array<fptype, Dynamic, 1> n_up( s * s, 1 );
-  Array<fptype, Dynamic, 1> n_down( s * s, 1 );
-  if ( settings.init == 0 ) {
-    for ( int i = 0; i < s * s; ++i ) {
-      n_up( i ) = gsl_rng_uniform_pos( rng );
-      n_down( i ) = gsl_rng_uniform_pos( rng );
-    }
-  } else if ( settings.init == 1 ) {
-    for ( int i = 0; i < s * s; ++i ) {
-      n_up( i ) =   ( ( i + i / s ) % 2 == 0 ? 1.0 : 0.0 );
-      n_down( i ) = ( ( i + i / s ) % 2 == 1 ? 1.0 : 0.0 );
-    }
-  } else if ( settings.init == 2 ) {
-    n_up   = Array<fptype, Dynamic, 1>::Constant( s * s, 1, 0.5 );
-    n_down = Array<fptype, Dynamic, 1>::Constant( s * s, 1, 0.5 );
-  } else {
+  Array<fptype, Dynamic, 1> n_up;
+  Array<fptype, Dynamic, 1> n_down;
+  if ( init_mean_fields( settings, id, rng, n_up, n_down, start ) != 0 ) {
     #pragma omp critical (output)
     { cerr << id << ": ERROR -> unknown initialization!" << endl; }
     gsl_rng_free( rng );
     return results;
   }
 
-  // construct the tight-binding part of H_sigma
+  // get the tight-binding part of H_sigma
   // (it doesn't change with the iterations, so
   //  we only need to calculate its matrix once)
-  Matrix<fptype, Dynamic, Dynamic> H_tb
-                       = Matrix<fptype, Dynamic, Dynamic>::Zero( s * s, s * s );
-  for ( int i = 0; i < s * s; ++i ) {
-    // calculate the position of atom i in the lattice
-    const int x = idx2x( i, s );
-    const int y = idx2y( i, s );
-
-    // nearest neighbour hopping
-    H_tb( i, xy2idx( x - 1, y, s ) ) -= t;
-    H_tb( i, xy2idx( x + 1, y, s ) ) -= t;
-    H_tb( i, xy2idx( x, y - 1, s ) ) -= t;
-    H_tb( i, xy2idx( x, y + 1, s ) ) -= t;
-
-    // diagonal hopping
-    H_tb( i, xy2idx( x - 1, y + 1, s ) ) -= t_prime;
-    H_tb( i, xy2idx( x + 1, y - 1, s ) ) -= t_prime;
-  }
+  prepare_workspace( settings, workspace );
+
+  // the subspace iteration only needs the nonzero elements of H_tb and
+  // the lowest states plus a few above them
+  const int N_subspace = s * s / 2 + max( 4, s * s / 20 );
+  const bool use_subspace = ( settings.eigensolver == 1 && N_subspace < s * s );
+
+  // threads working on this calculation: up and down are independent and
+  // are diagonalized concurrently if there is more than one
+  const int threads = max( 1, settings.threads_per_scc );
+  const int spin_threads = min( 2, threads );
+
+  // mixed precision: H is diagonalized in single precision until the
+  // residual is below refine_below, the final iterations and therefore the
+  // results are calculated in fptype
+  const bool mixed = ( settings.precision == 1 && !use_subspace
+                       && sizeof( fptype ) > sizeof( float ) );
+  spins.prepare( settings, workspace, mixed );
+  bool single = false;
+  bool refining = false;
 
   // save the old mean field parameters
   Array<fptype, Dynamic, 1> n_up_old = n_up;
@@ -100,32 +364,87 @@ SCCResults run_scc( const GlobalSettings& settings, const int& id )
 
   // forward declare variables needed in the SCC
 
-  Matrix<fptype, Dynamic, Dynamic> H_up;
-  Matrix<fptype, Dynamic, Dynamic> H_down;
+  // (lowest) eigenvalues of H_up and H_down, the eigenvectors are kept by
+  // the spins
+  Array<fptype, Dynamic, 1> epsilon_up;
+  Array<fptype, Dynamic, 1> epsilon_down;
+
+  // output mean field parameters of an iteration
+  Array<fptype, Dynamic, 1> n_up_new;
+  Array<fptype, Dynamic, 1> n_down_new;
+
+  // chemical potential and occupations of the states with smearing
+  fptype mu = 0.0;
+  Array<fptype, Dynamic, 1> w_up;
+  Array<fptype, Dynamic, 1> w_down;
 
-  SelfAdjointEigenSolver< Matrix<fptype, Dynamic, Dynamic> > solver_H_up;
-  SelfAdjointEigenSolver< Matrix<fptype, Dynamic, Dynamic> > solver_H_down;
+  // history of the mixing scheme
+  MixerState mixer;
 
-  // iteration counter
-  int iter = 0;
+  // iteration counter (an interrupted calculation continues from its
+  // checkpoint, the subspace iteration then restarts with a full
+  // diagonalization)
+  const int iter_resumed =
+    resume_checkpoint( settings, id, n_up, n_down, mixer, rng );
+  int iter = iter_resumed;
 
   do {
     ++iter;
+    const double t_start = trace_clock( trace );
+    single = ( mixed && !refining );
 
     // construct H_up and H_down from the mean field parameters <n_i,sigma>
-    H_up = H_tb;
-    H_up += ( U * n_down ).matrix().asDiagonal();
-    H_down = H_tb;
-    H_down += ( U * n_up ).matrix().asDiagonal();
-
-    // diagonalize H_up and H_down
-    solver_H_up.compute( H_up );
-    solver_H_down.compute( H_down );
-    if ( solver_H_up.info() == NoConvergence ||
-         solver_H_down.info() == NoConvergence ) {
+    // and diagonalize them, or refine the previous eigenpairs with the
+    // subspace iteration (all states are needed to draw the FD start, the
+    // starting subspace or the occupied states and the gap otherwise)
+    const bool refine = ( use_subspace && iter > iter_resumed + 1 );
+    const int N_lowest = ( ( iter == 1 && fd_start ) || smeared ) ? s * s
+                         : use_subspace ? N_subspace
+                         : min( s * s / 2 + 2, s * s );
+    const int status = spins.solve( refine, N_lowest, single, U, n_up, n_down,
+                                    spin_threads, epsilon_up, epsilon_down );
+    if ( status != 0 ) {
       #pragma omp critical (output)
-      { cerr << id << ": ERROR -> diagonalization did not converge!" << endl; }
+      {
+        cerr << id << ( status == 2 ? ": ERROR -> subspace iteration failed!"
+                        : ": ERROR -> diagonalization did not converge!" )
+             << endl;
+      }
+      gsl_rng_free( rng );
+      return results;
+    }
+
+    // occupy the states of both spins up to the chemical potential that
+    // gives the requested filling
+    if ( smeared ) {
+      const fptype width = smearing_width( settings, iter );
+      if ( find_chemical_potential( settings.smearing, width,
+                                    epsilon_up, epsilon_down,
+                                    settings.filling * 2 * s * s, mu ) != 0 ) {
+        #pragma omp critical (output)
+        { cerr << id << ": ERROR -> filling out of range!" << endl; }
+        gsl_rng_free( rng );
+        return results;
+      }
+      smeared_weights( settings.smearing, width, mu, epsilon_up, w_up );
+      smeared_weights( settings.smearing, width, mu, epsilon_down, w_down );
+    }
+
+    const double t_solved = trace_clock( trace );
+
+    // give up if this calculation is heading for a higher energy than the
+    // best one found so far
+    const fptype E_band =
+      smeared ? fptype( ( w_up * epsilon_up.head( w_up.size() ) ).sum()
+                        + ( w_down * epsilon_down.head( w_down.size() ) ).sum() )
+              : fptype( ( epsilon_up.head( s * s / 2 )
+                          + epsilon_down.head( s * s / 2 ) ).sum() );
+    if ( hopeless( settings, bound, iter, E_band ) ) {
       gsl_rng_free( rng );
+      results.pruned = true;
+      results.iterations_to_convergence = iter;
+      results.energy = E_band;
+      results.exit_code = 0;
       return results;
     }
 
@@ -133,36 +452,22 @@ SCCResults run_scc( const GlobalSettings& settings, const int& id )
     n_up_old = n_up;
     n_down_old = n_down;
 
+    double t_density;
+    fptype mixing = 1.0;
 
-
-    if ( iter == 1 && settings.init == 2 ) {
+    if ( iter == 1 && fd_start ) {
 
       // calculate the fermi energy
-      fptype E_fermi = 0.5 * ( solver_H_up.eigenvalues()( ( s * s / 2 ) - 1 ) +
-                               solver_H_down.eigenvalues()( ( s * s / 2 ) - 1 ) );
-
-      // create arrays to store which states are occupied
-      vector<bool> occupied_up( s * s, false );
-      vector<bool> occupied_down( s * s, false );
+      fptype E_fermi = 0.5 * ( epsilon_up( ( s * s / 2 ) - 1 ) +
+                               epsilon_down( ( s * s / 2 ) - 1 ) );
 
       // find occupied states according to the fermi distribution
-      while ( ( int ) count( occupied_up.begin(), occupied_up.end(), true )
-                                                                != s * s / 2 ) {
-        for ( int i = 0; i < s * s; ++i ) {
-          fptype fdi_up  = fermifunc( solver_H_up.eigenvalues()( i ),
-                                                         E_fermi, settings.kT );
-          occupied_up[i] = ( fdi_up == 1.0 || gsl_rng_uniform( rng ) < fdi_up );
-        }
-      }
-      while ( ( int ) count( occupied_down.begin(), occupied_down.end(), true )
-                                                                != s * s / 2 ) {
-        for ( int i = 0; i < s * s; ++i ) {
-          fptype fdi_down  = fermifunc( solver_H_up.eigenvalues()( i ),
-                                        E_fermi, settings.kT );
-          occupied_down[i] = ( fdi_down == 1.0 ||
-                               gsl_rng_uniform( rng ) < fdi_down );
-        }
-      }
+      const vector<bool> occupied_up =
+        draw_fd_occupations( epsilon_up, E_fermi, settings.kT,
+                             s * s / 2, rng );
+      const vector<bool> occupied_down =
+        draw_fd_occupations( epsilon_down, E_fermi, settings.kT,
+                             s * s / 2, rng );
 
 #ifdef _VERBOSE
       cout << "Initial occupied states according to FD-statistics:" << endl;
@@ -176,36 +481,30 @@ SCCResults run_scc( const GlobalSettings& settings, const int& id )
       cout << endl << endl;
 #endif
 
-      // reset mean field parameters to zero
-      n_up   = Array<fptype, Dynamic, 1>::Constant( s * s, 1, 0.0 );
-      n_down = Array<fptype, Dynamic, 1>::Constant( s * s, 1, 0.0 );
-
-      // add the contributions of the individual eigenstates
-      for ( int alpha = 0; alpha < s * s; ++alpha ) {
-        if ( occupied_up[alpha] ) {
-          n_up += solver_H_up.eigenvectors().col( alpha ).array().square();
-        }
-        if ( occupied_down[alpha] ) {
-          n_down += solver_H_down.eigenvectors().col( alpha ).array().square();
-        }
-      }
+      // the new mean field parameters are the sum of the contributions of
+      // the occupied eigenstates
+      spins.drawn_density( single, occupied_up, occupied_down, n_up, n_down );
+      t_density = trace_clock( trace );
     } else {
+      if ( smeared ) {
+        spins.smeared_density( single, w_up, w_down, threads,
+                               n_up_new, n_down_new );
+      } else {
+        spins.density( single, s * s / 2, threads, n_up_new, n_down_new );
+      }
+      t_density = trace_clock( trace );
+
       // update mean field parameters with mixing
-      fptype mix = 0.5 * gsl_rng_uniform_pos( rng );
-
-      n_up   = ( 0.25 + mix ) * solver_H_up.eigenvectors()
-               .array().block( 0, 0, s * s, s * s / 2 ).square().rowwise().sum()
-               + ( 0.75 - mix ) * n_up;
-      n_down = ( 0.25 + mix ) * solver_H_down.eigenvectors()
-               .array().block( 0, 0, s * s, s * s / 2 ).square().rowwise().sum()
-               + ( 0.75 - mix ) * n_down;
+      mixing = mix_mean_fields( settings, mixer, rng, n_up, n_down,
+                                n_up_new, n_down_new );
     }
+    const double t_mixed = trace_clock( trace );
 
 #ifdef _VERBOSE
     cout << "Iteration " << iter << ": "
          << ( n_up - n_up_old ).square().sum() << ' '
          << ( n_down - n_down_old ).square().sum() << ' '
-         << ( solver_H_up.eigenvalues() + solver_H_down.eigenvalues() )
+         << ( epsilon_up + epsilon_down )
             .head( s * s / 2 ).sum() << endl;
     cout << n_up.transpose().head( 5 ) << endl;
     cout << n_down.transpose().head( 5 ) << endl;
@@ -213,7 +512,32 @@ SCCResults run_scc( const GlobalSettings& settings, const int& id )
     cout.flush();
 #endif
 
-  } while ( ( ( n_up - n_up_old ).array().abs().maxCoeff() > m_prec
+    // save the state of the cycle from time to time
+    if ( checkpoint_due( settings, iter ) &&
+         write_checkpoint( settings, id, iter, n_up, n_down, mixer,
+                           rng ) != 0 ) {
+      #pragma omp critical (output)
+      { cerr << id << ": WARNING -> unable to write checkpoint!" << endl; }
+    }
+
+    if ( trace != NULL ) {
+      add_trace_event( trace, id, iter,
+                       ( n_up - n_up_old ).abs().maxCoeff(),
+                       ( n_down - n_down_old ).abs().maxCoeff(),
+                       E_band, mixing, t_start, t_solved, t_density, t_mixed );
+    }
+
+    // switch to full precision once single precision starts to limit the
+    // convergence (a cycle only counts as converged in full precision)
+    if ( single &&
+         ( n_up - n_up_old ).abs().maxCoeff() < max( settings.refine_below, m_prec )
+         && ( n_down - n_down_old ).abs().maxCoeff() < max( settings.refine_below, m_prec ) ) {
+      refining = true;
+    }
+
+  } while ( ( single
+              || ( smeared && !smearing_annealed( settings, iter ) )
+              || ( n_up - n_up_old ).array().abs().maxCoeff() > m_prec
               || ( n_down - n_down_old ).array().abs().maxCoeff() > m_prec )
             && iter < settings.max_iterations );
 
@@ -227,33 +551,308 @@ SCCResults run_scc( const GlobalSettings& settings, const int& id )
 
   // ----- RESULT OUTPUT -----
 
-  results.converged = ( n_up - n_up_old ).array().abs().maxCoeff() < m_prec
+  results.converged = !single
+                      && ( !smeared || smearing_annealed( settings, iter ) )
+                      && ( n_up - n_up_old ).array().abs().maxCoeff() < m_prec
                       && ( n_down - n_down_old ).array().abs().maxCoeff() < m_prec;
   results.iterations_to_convergence = iter;
   results.Delta_n_up = ( n_up - n_up_old ).array().abs().maxCoeff();
   results.Delta_n_down = ( n_down - n_down_old ).array().abs().maxCoeff();
 
-  results.energy = ( solver_H_up.eigenvalues() + solver_H_down.eigenvalues() )
-                   .head( s * s / 2 ).sum();
-  results.gap = min( solver_H_up.eigenvalues()( ( s * s / 2 ) + 1 )
-                                       - solver_H_up.eigenvalues()( s * s / 2 ),
-                     solver_H_down.eigenvalues()( ( s * s / 2 ) + 1 )
-                                   - solver_H_down.eigenvalues()( s * s / 2 ) );
+  if ( smeared ) {
+    results.energy = ( w_up * epsilon_up.head( w_up.size() ) ).sum()
+                     + ( w_down * epsilon_down.head( w_down.size() ) ).sum();
+    results.gap = gap_at( mu, epsilon_up, epsilon_down );
+  } else {
+    results.energy = ( epsilon_up + epsilon_down )
+                     .head( s * s / 2 ).sum();
+    results.gap = min( epsilon_up( ( s * s / 2 ) + 1 )
+                                         - epsilon_up( s * s / 2 ),
+                       epsilon_down( ( s * s / 2 ) + 1 )
+                                     - epsilon_down( s * s / 2 ) );
+  }
   results.m_z = n_up.sum() - n_down.sum();
   results.filling =   ( n_up.sum() + n_down.sum() )
                     / static_cast<fptype>( s * s * 2 );
 
-  results.n_up = n_up;
-  results.n_down = n_down;
-  results.epsilon_up = solver_H_up.eigenvalues();
-  results.epsilon_down = solver_H_down.eigenvalues();
-  results.Q_up = solver_H_up.eigenvectors();
-  results.Q_down = solver_H_down.eigenvectors();
+  // hand the arrays over without copying them, the eigenvectors are
+  // 2*(s*s)^2 numbers and dropped unless they were requested
+  results.n_up.swap( n_up );
+  results.n_down.swap( n_down );
+  results.epsilon_up.swap( epsilon_up );
+  results.epsilon_down.swap( epsilon_down );
+  if ( settings.keep_eigenvectors ) {
+    spins.eigenvectors( single, results.Q_up, results.Q_down );
+  }
 
   results.exit_code = 0;
   return results;
 }
 
+// (the sizes of fixed_sizes in scc_fixed.cpp)
+template SCCResults run_scc_dense( const GlobalSettings& settings,
+                                   const int& id, const SCCResults* start,
+                                   SCCWorkspace& workspace,
+                                   const SCCBound* bound,
+                                   vector<TraceEvent>* trace,
+                                   FixedSpins<4>& spins );
+template SCCResults run_scc_dense( const GlobalSettings& settings,
+                                   const int& id, const SCCResults* start,
+                                   SCCWorkspace& workspace,
+                                   const SCCBound* bound,
+                                   vector<TraceEvent>* trace,
+                                   FixedSpins<6>& spins );
+template SCCResults run_scc_dense( const GlobalSettings& settings,
+                                   const int& id, const SCCResults* start,
+                                   SCCWorkspace& workspace,
+                                   const SCCBound* bound,
+                                   vector<TraceEvent>* trace,
+                                   FixedSpins<8>& spins );
+template SCCResults run_scc_dense( const GlobalSettings& settings,
+                                   const int& id, const SCCResults* start,
+                                   SCCWorkspace& workspace,
+                                   const SCCBound* bound,
+                                   vector<TraceEvent>* trace,
+                                   FixedSpins<10>& spins );
+
+bool hopeless( const GlobalSettings& settings, const SCCBound* bound,
+               const int& iter, const fptype& E_band )
+{
+  // a calculation is considered hopeless if the band energy of its current
+  // iteration is still more than prune_tolerance per site above the best
+  // converged energy after prune_iterations iterations
+  if ( bound == NULL || settings.prune == 0
+       || iter < settings.prune_iterations ) {
+    return false;
+  }
+
+  fptype E_best;
+  #pragma omp atomic read
+  E_best = bound->energy;
+
+  return E_band > E_best
+                  + settings.prune_tolerance * settings.s * settings.s;
+}
+
+template <typename Scalar>
+void build_H_sigma( const Matrix<Scalar, Dynamic, Dynamic>& H_tb,
+                    const fptype& U,
+                    const Array<fptype, Dynamic, 1>& n_other,
+                    Matrix<Scalar, Dynamic, Dynamic>& H,
+                    const bool& diagonal_only )
+{
+  // H_sigma = H_tb + U * diag(<n_i,-sigma>)
+  // (all diagonalizers only read the lower triangle, so the upper one is not
+  //  copied, and only the diagonal is written if H already is H_sigma of
+  //  other mean field parameters)
+  if ( !diagonal_only || H.rows() != H_tb.rows() ) {
+    H.resize( H_tb.rows(), H_tb.cols() );
+    H.template triangularView<StrictlyLower>() = H_tb;
+  }
+  H.diagonal() = H_tb.diagonal() + ( U * n_other ).cast<Scalar>().matrix();
+}
+
+template void build_H_sigma( const Matrix<float, Dynamic, Dynamic>& H_tb,
+                             const fptype& U,
+                             const Array<fptype, Dynamic, 1>& n_other,
+                             Matrix<float, Dynamic, Dynamic>& H,
+                             const bool& diagonal_only );
+template void build_H_sigma( const Matrix<double, Dynamic, Dynamic>& H_tb,
+                             const fptype& U,
+                             const Array<fptype, Dynamic, 1>& n_other,
+                             Matrix<double, Dynamic, Dynamic>& H,
+                             const bool& diagonal_only );
+
+template <typename Scalar>
+void occupied_density( const Matrix<Scalar, Dynamic, Dynamic>& Q_up,
+                       const Matrix<Scalar, Dynamic, Dynamic>& Q_down,
+                       const int& N_occ, const int& threads,
+                       Array<fptype, Dynamic, 1>& n_up,
+                       Array<fptype, Dynamic, 1>& n_down )
+{
+  // calculate the density of the N_occ lowest eigenstates (the diagonal of
+  // Q_occ Q_occ^T) of both spins in one pass over blocks of rows, which are
+  // distributed over the threads: the sums of a block stay in the L1 cache
+  // while the occupied columns stream through it (Q_down may be Q_up, then
+  // its density is only calculated once)
+
+  const int N = Q_up.rows();
+  const int block = 128;
+  const bool same = ( &Q_up == &Q_down );
+
+  n_up.resize( N );
+  n_down.resize( N );
+  #pragma omp parallel for num_threads( threads ) schedule( static )
+  for ( int row = 0; row < N; row += block ) {
+    const int rows = min( block, N - row );
+    Array<Scalar, Dynamic, 1, 0, block, 1> sum( rows );
+
+    sum.setZero();
+    for ( int alpha = 0; alpha < N_occ; ++alpha ) {
+      sum += Q_up.col( alpha ).segment( row, rows ).array().square();
+    }
+    n_up.segment( row, rows ) = sum.template cast<fptype>();
+
+    if ( !same ) {
+      sum.setZero();
+      for ( int alpha = 0; alpha < N_occ; ++alpha ) {
+        sum += Q_down.col( alpha ).segment( row, rows ).array().square();
+      }
+      n_down.segment( row, rows ) = sum.template cast<fptype>();
+    }
+  }
+  if ( same ) {
+    n_down = n_up;
+  }
+}
+
+template void occupied_density( const Matrix<float, Dynamic, Dynamic>& Q_up,
+                                const Matrix<float, Dynamic, Dynamic>& Q_down,
+                                const int& N_occ, const int& threads,
+                                Array<fptype, Dynamic, 1>& n_up,
+                                Array<fptype, Dynamic, 1>& n_down );
+template void occupied_density( const Matrix<double, Dynamic, Dynamic>& Q_up,
+                                const Matrix<double, Dynamic, Dynamic>& Q_down,
+                                const int& N_occ, const int& threads,
+                                Array<fptype, Dynamic, 1>& n_up,
+                                Array<fptype, Dynamic, 1>& n_down );
+
+template <typename Scalar>
+void weighted_density( const Matrix<Scalar, Dynamic, Dynamic>& Q_up,
+                       const Matrix<Scalar, Dynamic, Dynamic>& Q_down,
+                       const Array<fptype, Dynamic, 1>& w_up,
+                       const Array<fptype, Dynamic, 1>& w_down,
+                       const int& threads,
+                       Array<fptype, Dynamic, 1>& n_up,
+                       Array<fptype, Dynamic, 1>& n_down )
+{
+  // like occupied_density, but every eigenstate contributes with its
+  // occupation w (only the first w.size() states are occupied at all)
+
+  const int N = Q_up.rows();
+  const int block = 128;
+
+  n_up.resize( N );
+  n_down.resize( N );
+  #pragma omp parallel for num_threads( threads ) schedule( static )
+  for ( int row = 0; row < N; row += block ) {
+    const int rows = min( block, N - row );
+    Array<Scalar, Dynamic, 1, 0, block, 1> sum( rows );
+
+    sum.setZero();
+    for ( int alpha = 0; alpha < w_up.size(); ++alpha ) {
+      sum += Scalar( w_up( alpha ) )
+             * Q_up.col( alpha ).segment( row, rows ).array().square();
+    }
+    n_up.segment( row, rows ) = sum.template cast<fptype>();
+
+    sum.setZero();
+    for ( int alpha = 0; alpha < w_down.size(); ++alpha ) {
+      sum += Scalar( w_down( alpha ) )
+             * Q_down.col( alpha ).segment( row, rows ).array().square();
+    }
+    n_down.segment( row, rows ) = sum.template cast<fptype>();
+  }
+}
+
+template void weighted_density( const Matrix<float, Dynamic, Dynamic>& Q_up,
+                                const Matrix<float, Dynamic, Dynamic>& Q_down,
+                                const Array<fptype, Dynamic, 1>& w_up,
+                                const Array<fptype, Dynamic, 1>& w_down,
+                                const int& threads,
+                                Array<fptype, Dynamic, 1>& n_up,
+                                Array<fptype, Dynamic, 1>& n_down );
+template void weighted_density( const Matrix<double, Dynamic, Dynamic>& Q_up,
+                                const Matrix<double, Dynamic, Dynamic>& Q_down,
+                                const Array<fptype, Dynamic, 1>& w_up,
+                                const Array<fptype, Dynamic, 1>& w_down,
+                                const int& threads,
+                                Array<fptype, Dynamic, 1>& n_up,
+                                Array<fptype, Dynamic, 1>& n_down );
+
+void prepare_workspace( const GlobalSettings& settings,
+                        SCCWorkspace& workspace )
+{
+  // (re)calculate the tight-binding part of H_sigma if the workspace was
+  // prepared for a different lattice or hopping
+
+  int const& s = settings.s;
+  fptype const& t = settings.t;
+  fptype const& t_prime = settings.t_prime;
+
+  if ( workspace.s == s && workspace.t == t && workspace.t_prime == t_prime ) {
+    return;
+  }
+  workspace.s = s;
+  workspace.t = t;
+  workspace.t_prime = t_prime;
+
+  Matrix<fptype, Dynamic, Dynamic>& H_tb = workspace.H_tb;
+  H_tb = Matrix<fptype, Dynamic, Dynamic>::Zero( s * s, s * s );
+  for ( int i = 0; i < s * s; ++i ) {
+    // calculate the position of atom i in the lattice
+    const int x = idx2x( i, s );
+    const int y = idx2y( i, s );
+
+    // nearest neighbour hopping
+    H_tb( i, xy2idx( x - 1, y, s ) ) -= t;
+    H_tb( i, xy2idx( x + 1, y, s ) ) -= t;
+    H_tb( i, xy2idx( x, y - 1, s ) ) -= t;
+    H_tb( i, xy2idx( x, y + 1, s ) ) -= t;
+
+    // diagonal hopping
+    H_tb( i, xy2idx( x - 1, y + 1, s ) ) -= t_prime;
+    H_tb( i, xy2idx( x + 1, y - 1, s ) ) -= t_prime;
+  }
+
+  workspace.H_tb_sparse = H_tb.sparseView();
+
+  // (the single precision copy is made by the first calculation needing it)
+  workspace.H_tb_single.resize( 0, 0 );
+}
+
+int init_mean_fields( const GlobalSettings& settings, const int& id,
+                      gsl_rng* rng,
+                      Array<fptype, Dynamic, 1>& n_up,
+                      Array<fptype, Dynamic, 1>& n_down,
+                      const SCCResults* start )
+{
+  // initialize the mean field parameters <n_i,sigma> on the s*s lattice
+
+  int const& s = settings.s;
+
+  // continue from a given solution if there is one
+  if ( start != NULL && start->n_up.size() == s * s
+                     && start->n_down.size() == s * s ) {
+    n_up = start->n_up;
+    n_down = start->n_down;
+    return 0;
+  }
+
+  n_up.resize( s * s );
+  n_down.resize( s * s );
+  if ( settings.init == 0 ) {
+    for ( int i = 0; i < s * s; ++i ) {
+      n_up( i ) = gsl_rng_uniform_pos( rng );
+      n_down( i ) = gsl_rng_uniform_pos( rng );
+    }
+  } else if ( settings.init == 1 ) {
+    for ( int i = 0; i < s * s; ++i ) {
+      n_up( i ) =   ( ( i + i / s ) % 2 == 0 ? 1.0 : 0.0 );
+      n_down( i ) = ( ( i + i / s ) % 2 == 1 ? 1.0 : 0.0 );
+    }
+  } else if ( settings.init == 2 ) {
+    n_up   = Array<fptype, Dynamic, 1>::Constant( s * s, 1, settings.filling );
+    n_down = Array<fptype, Dynamic, 1>::Constant( s * s, 1, settings.filling );
+  } else if ( settings.init == 3 ) {
+    return seed_mean_fields( settings, id, rng, n_up, n_down );
+  } else {
+    return 1;
+  }
+
+  return 0;
+}
+
 fptype fermifunc( fptype const& E, fptype const& E_fermi, fptype const& kT )
 {
   // the Fermi-Dirac distribution
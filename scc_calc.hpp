@@ -36,9 +36,86 @@ using namespace Eigen;
 #include "settings.hpp"
 #include "lattice.hpp"
 #include "scc_inout.hpp"
+#include "eigensolver.hpp"
+#include "mixer.hpp"
+#include "rng.hpp"
+#include "smearing.hpp"
+#include "fd_sampler.hpp"
+#include "seeds.hpp"
+#include "checkpoint.hpp"
+#include "trace.hpp"
+#include "scc_kspace.hpp"
+#include "scc_kpm.hpp"
+#include "scc_fixed.hpp"
+#include "scc_spiral.hpp"
 
 
-SCCResults run_scc( const GlobalSettings& settings, const int& id );
+// parts of the calculation that only depend on the lattice and the hopping
+// and can be reused by all calculations of the same system
+struct SCCWorkspace {
+  int s;
+  fptype t, t_prime;
+
+  // tight-binding part of H_sigma
+  Matrix<fptype, Dynamic, Dynamic> H_tb;
+  SparseMatrix<fptype> H_tb_sparse;
+  Matrix<float, Dynamic, Dynamic> H_tb_single;
+
+  // iterations traced by the calculations of this thread
+  vector<TraceEvent> trace;
+
+  SCCWorkspace() : s( 0 ), t( 0.0 ), t_prime( 0.0 ) { }
+};
+
+SCCResults run_scc( const GlobalSettings& settings, const int& id,
+                    const SCCResults* start = NULL,
+                    SCCWorkspace* workspace = NULL,
+                    const SCCBound* bound = NULL );
+
+// the self-consistency cycle of engine 0, where Spins holds H_up and H_down
+// and their eigenpairs: DenseSpins of scc_calc.cpp for any lattice or the
+// FixedSpins of scc_fixed.hpp for the small ones
+template <typename Spins>
+SCCResults run_scc_dense( const GlobalSettings& settings, const int& id,
+                          const SCCResults* start, SCCWorkspace& workspace,
+                          const SCCBound* bound, vector<TraceEvent>* trace,
+                          Spins& spins );
+
+bool hopeless( const GlobalSettings& settings, const SCCBound* bound,
+               const int& iter, const fptype& E_band );
+
+void prepare_workspace( const GlobalSettings& settings,
+                        SCCWorkspace& workspace );
+
+// (instantiated for float and double like diagonalize)
+template <typename Scalar>
+void build_H_sigma( const Matrix<Scalar, Dynamic, Dynamic>& H_tb,
+                    const fptype& U,
+                    const Array<fptype, Dynamic, 1>& n_other,
+                    Matrix<Scalar, Dynamic, Dynamic>& H,
+                    const bool& diagonal_only = false );
+
+template <typename Scalar>
+void occupied_density( const Matrix<Scalar, Dynamic, Dynamic>& Q_up,
+                       const Matrix<Scalar, Dynamic, Dynamic>& Q_down,
+                       const int& N_occ, const int& threads,
+                       Array<fptype, Dynamic, 1>& n_up,
+                       Array<fptype, Dynamic, 1>& n_down );
+
+template <typename Scalar>
+void weighted_density( const Matrix<Scalar, Dynamic, Dynamic>& Q_up,
+                       const Matrix<Scalar, Dynamic, Dynamic>& Q_down,
+                       const Array<fptype, Dynamic, 1>& w_up,
+                       const Array<fptype, Dynamic, 1>& w_down,
+                       const int& threads,
+                       Array<fptype, Dynamic, 1>& n_up,
+                       Array<fptype, Dynamic, 1>& n_down );
+
+int init_mean_fields( const GlobalSettings& settings, const int& id,
+                      gsl_rng* rng,
+                      Array<fptype, Dynamic, 1>& n_up,
+                      Array<fptype, Dynamic, 1>& n_down,
+                      const SCCResults* start = NULL );
 
 fptype fermifunc( const fptype& E, const fptype& E_fermi, const fptype& kT );
 
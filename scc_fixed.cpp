@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "scc_fixed.hpp"
+#include "scc_calc.hpp"
+
+template <int S, typename Scalar>
+static void fixed_H_tb( const Matrix<fptype, Dynamic, Dynamic>& H_tb,
+                        FixedHamiltonians<S, Scalar>& h )
+{
+  // copy the tight-binding part of H_sigma from the workspace
+  // (the iterations only change the diagonals of H_up and H_down)
+  h.H_tb = H_tb.template cast<Scalar>();
+  h.H_up = h.H_tb;
+  h.H_down = h.H_tb;
+}
+
+template <int S, typename Scalar>
+static int fixed_solve( FixedHamiltonians<S, Scalar>& h, const bool& same,
+                        const fptype& U,
+                        const Array<fptype, Dynamic, 1>& n_up,
+                        const Array<fptype, Dynamic, 1>& n_down,
+                        const int& spin_threads,
+                        Array<fptype, Dynamic, 1>& epsilon_up,
+                        Array<fptype, Dynamic, 1>& epsilon_down )
+{
+  // update the diagonals of H_up and H_down and diagonalize them
+  // concurrently, or only once if they are the same
+  int status_up = 0, status_down = 0;
+  #pragma omp parallel sections num_threads( same ? 1 : spin_threads )
+  {
+    #pragma omp section
+    {
+      h.H_up.diagonal() = h.H_tb.diagonal()
+                          + ( U * n_down ).template cast<Scalar>().matrix();
+      h.solver_up.compute( h.H_up );
+      status_up = ( h.solver_up.info() == NoConvergence );
+    }
+    #pragma omp section
+    {
+      if ( !same ) {
+        h.H_down.diagonal() = h.H_tb.diagonal()
+                              + ( U * n_up ).template cast<Scalar>().matrix();
+        h.solver_down.compute( h.H_down );
+        status_down = ( h.solver_down.info() == NoConvergence );
+      }
+    }
+  }
+  if ( status_up != 0 || status_down != 0 ) {
+    return 1;
+  }
+  if ( same ) {
+    h.solver_down = h.solver_up;
+  }
+  epsilon_up = h.solver_up.eigenvalues().template cast<fptype>();
+  epsilon_down = h.solver_down.eigenvalues().template cast<fptype>();
+  return 0;
+}
+
+template <int S, typename Scalar>
+static void fixed_density( const FixedHamiltonians<S, Scalar>& h,
+                           const bool& same,
+                           Array<fptype, Dynamic, 1>& n_up,
+                           Array<fptype, Dynamic, 1>& n_down )
+{
+  // density of the S*S/2 lowest eigenstates
+  n_up = h.solver_up.eigenvectors().template leftCols<S * S / 2>()
+         .array().square().rowwise().sum().template cast<fptype>();
+  if ( same ) {
+    n_down = n_up;
+  } else {
+    n_down = h.solver_down.eigenvectors().template leftCols<S * S / 2>()
+             .array().square().rowwise().sum().template cast<fptype>();
+  }
+}
+
+template <int S, typename Scalar>
+static void fixed_smeared_density( const FixedHamiltonians<S, Scalar>& h,
+                                   const Array<fptype, Dynamic, 1>& w_up,
+                                   const Array<fptype, Dynamic, 1>& w_down,
+                                   Array<fptype, Dynamic, 1>& n_up,
+                                   Array<fptype, Dynamic, 1>& n_down )
+{
+  // density of the eigenstates weighted with their occupations
+  n_up = ( h.solver_up.eigenvectors().leftCols( w_up.size() ).array().square()
+           .matrix() * w_up.template cast<Scalar>().matrix() )
+         .array().template cast<fptype>();
+  n_down = ( h.solver_down.eigenvectors().leftCols( w_down.size() ).array()
+             .square().matrix() * w_down.template cast<Scalar>().matrix() )
+           .array().template cast<fptype>();
+}
+
+template <int S, typename Scalar>
+static void fixed_drawn_density( const FixedHamiltonians<S, Scalar>& h,
+                                 const vector<bool>& occupied_up,
+                                 const vector<bool>& occupied_down,
+                                 Array<fptype, Dynamic, 1>& n_up,
+                                 Array<fptype, Dynamic, 1>& n_down )
+{
+  // density of the given eigenstates
+  n_up.setZero( S * S );
+  n_down.setZero( S * S );
+  for ( int alpha = 0; alpha < S * S; ++alpha ) {
+    if ( occupied_up[alpha] ) {
+      n_up += h.solver_up.eigenvectors().col( alpha ).array().square()
+              .template cast<fptype>();
+    }
+    if ( occupied_down[alpha] ) {
+      n_down += h.solver_down.eigenvectors().col( alpha ).array().square()
+                .template cast<fptype>();
+    }
+  }
+}
+
+template <int S>
+void FixedSpins<S>::prepare( const GlobalSettings& settings,
+                             SCCWorkspace& workspace, const bool& mixed )
+{
+  fixed_H_tb( workspace.H_tb, full );
+  if ( mixed ) {
+    fixed_H_tb( workspace.H_tb, reduced );
+  }
+  same = false;
+}
+
+template <int S>
+int FixedSpins<S>::solve( const bool& refine, const int& N_lowest,
+                          const bool& single, const fptype& U,
+                          const Array<fptype, Dynamic, 1>& n_up,
+                          const Array<fptype, Dynamic, 1>& n_down,
+                          const int& spin_threads,
+                          Array<fptype, Dynamic, 1>& epsilon_up,
+                          Array<fptype, Dynamic, 1>& epsilon_down )
+{
+  // (all eigenpairs are calculated, there is no subspace iteration)
+  same = ( n_up == n_down ).all();
+  return single ? fixed_solve( reduced, same, U, n_up, n_down, spin_threads,
+                               epsilon_up, epsilon_down )
+                : fixed_solve( full, same, U, n_up, n_down, spin_threads,
+                               epsilon_up, epsilon_down );
+}
+
+template <int S>
+void FixedSpins<S>::density( const bool& single, const int& N_occ,
+                             const int& threads,
+                             Array<fptype, Dynamic, 1>& n_up,
+                             Array<fptype, Dynamic, 1>& n_down )
+{
+  // (N_occ is S*S/2)
+  if ( single ) {
+    fixed_density( reduced, same, n_up, n_down );
+  } else {
+    fixed_density( full, same, n_up, n_down );
+  }
+}
+
+template <int S>
+void FixedSpins<S>::smeared_density( const bool& single,
+                                     const Array<fptype, Dynamic, 1>& w_up,
+                                     const Array<fptype, Dynamic, 1>& w_down,
+                                     const int& threads,
+                                     Array<fptype, Dynamic, 1>& n_up,
+                                     Array<fptype, Dynamic, 1>& n_down )
+{
+  if ( single ) {
+    fixed_smeared_density( reduced, w_up, w_down, n_up, n_down );
+  } else {
+    fixed_smeared_density( full, w_up, w_down, n_up, n_down );
+  }
+}
+
+template <int S>
+void FixedSpins<S>::drawn_density( const bool& single,
+                                   const vector<bool>& occupied_up,
+                                   const vector<bool>& occupied_down,
+                                   Array<fptype, Dynamic, 1>& n_up,
+                                   Array<fptype, Dynamic, 1>& n_down )
+{
+  if ( single ) {
+    fixed_drawn_density( reduced, occupied_up, occupied_down, n_up, n_down );
+  } else {
+    fixed_drawn_density( full, occupied_up, occupied_down, n_up, n_down );
+  }
+}
+
+template <int S>
+void FixedSpins<S>::eigenvectors( const bool& single,
+                                  Matrix<fptype, Dynamic, Dynamic>& Q_up,
+                                  Matrix<fptype, Dynamic, Dynamic>& Q_down )
+{
+  if ( single ) {
+    Q_up = reduced.solver_up.eigenvectors().template cast<fptype>();
+    Q_down = reduced.solver_down.eigenvectors().template cast<fptype>();
+  } else {
+    Q_up = full.solver_up.eigenvectors();
+    Q_down = full.solver_down.eigenvectors();
+  }
+}
+
+template <int S>
+static SCCResults run_scc_fixed_size( const GlobalSettings& settings,
+                                      const int& id, const SCCResults* start,
+                                      SCCWorkspace& workspace,
+                                      const SCCBound* bound,
+                                      vector<TraceEvent>* trace )
+{
+  FixedSpins<S>* spins = new FixedSpins<S>;
+  SCCResults results = run_scc_dense( settings, id, start, workspace, bound,
+                                      trace, *spins );
+  delete spins;
+  return results;
+}
+
+typedef SCCResults ( *FixedSCC )( const GlobalSettings&, const int&,
+                                  const SCCResults*, SCCWorkspace&,
+                                  const SCCBound*, vector<TraceEvent>* );
+
+struct FixedSize {
+  int s;
+  FixedSCC run;
+};
+
+// lattice sizes with a compiled kernel (s*s*s*s*sizeof(double) has to be
+// below Eigen's limit of 128kB for fixed size matrices, so s=12 and larger
+// always use the dynamic path; run_scc_dense is instantiated for the same
+// sizes in scc_calc.cpp)
+template struct FixedSpins<4>;
+template struct FixedSpins<6>;
+template struct FixedSpins<8>;
+template struct FixedSpins<10>;
+
+static const FixedSize fixed_sizes[] = {
+  { 4,  &run_scc_fixed_size<4> },
+  { 6,  &run_scc_fixed_size<6> },
+  { 8,  &run_scc_fixed_size<8> },
+  { 10, &run_scc_fixed_size<10> }
+};
+
+static FixedSCC find_fixed_size( const int& s )
+{
+  for ( size_t i = 0; i < sizeof( fixed_sizes ) / sizeof( FixedSize ); ++i ) {
+    if ( fixed_sizes[i].s == s ) {
+      return fixed_sizes[i].run;
+    }
+  }
+  return NULL;
+}
+
+bool fixed_size_available( const GlobalSettings& settings )
+{
+  // the kernels only replace the full diagonalization with Eigen
+  return settings.fixed_size != 0
+         && settings.engine == 0
+         && settings.eigensolver == 0
+         && settings.diagonalizer == 0
+         && find_fixed_size( settings.s ) != NULL;
+}
+
+SCCResults run_scc_fixed( const GlobalSettings& settings, const int& id,
+                          const SCCResults* start, SCCWorkspace& workspace,
+                          const SCCBound* bound, vector<TraceEvent>* trace )
+{
+  const FixedSCC run = find_fixed_size( settings.s );
+  if ( run == NULL ) {
+    #pragma omp critical (output)
+    { cerr << id << ": ERROR -> no fixed size kernel for this lattice!" << endl; }
+    return SCCResults();
+  }
+  return run( settings, id, start, workspace, bound, trace );
+}
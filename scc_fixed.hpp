@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __SCC_FIXED_H_INCLUDED__
+#define __SCC_FIXED_H_INCLUDED__
+
+#include <iostream>
+#include <vector>
+using namespace std;
+
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Eigenvalues>
+using namespace Eigen;
+
+#include "typedefs.hpp"
+#include "settings.hpp"
+#include "scc_inout.hpp"
+#include "trace.hpp"
+
+struct SCCWorkspace;
+
+
+// H_up and H_down of the S x S lattice and their eigenpairs in the
+// precision Scalar
+template <int S, typename Scalar>
+struct FixedHamiltonians {
+  typedef Matrix<Scalar, S * S, S * S> MatrixSS;
+
+  MatrixSS H_tb;
+  MatrixSS H_up, H_down;
+  SelfAdjointEigenSolver<MatrixSS> solver_up, solver_down;
+};
+
+// the spins of run_scc_dense for the small lattices listed in scc_fixed.cpp:
+// the matrices have their size fixed at compile time (s*s <= 100, so that
+// they stay within Eigen's limit for fixed size objects) and the loops over
+// the sites are unrolled by the compiler
+// (a matrix of s=10 takes 80kB in double precision, which is too much for
+//  the stack of the threads, so this is allocated once per calculation)
+template <int S>
+struct FixedSpins {
+  FixedHamiltonians<S, fptype> full;
+  FixedHamiltonians<S, float> reduced;
+
+  // H_up == H_down in the last iteration
+  bool same;
+
+  void prepare( const GlobalSettings& settings, SCCWorkspace& workspace,
+                const bool& mixed );
+  int solve( const bool& refine, const int& N_lowest, const bool& single,
+             const fptype& U,
+             const Array<fptype, Dynamic, 1>& n_up,
+             const Array<fptype, Dynamic, 1>& n_down,
+             const int& spin_threads,
+             Array<fptype, Dynamic, 1>& epsilon_up,
+             Array<fptype, Dynamic, 1>& epsilon_down );
+  void density( const bool& single, const int& N_occ, const int& threads,
+                Array<fptype, Dynamic, 1>& n_up,
+                Array<fptype, Dynamic, 1>& n_down );
+  void smeared_density( const bool& single,
+                        const Array<fptype, Dynamic, 1>& w_up,
+                        const Array<fptype, Dynamic, 1>& w_down,
+                        const int& threads,
+                        Array<fptype, Dynamic, 1>& n_up,
+                        Array<fptype, Dynamic, 1>& n_down );
+  void drawn_density( const bool& single, const vector<bool>& occupied_up,
+                      const vector<bool>& occupied_down,
+                      Array<fptype, Dynamic, 1>& n_up,
+                      Array<fptype, Dynamic, 1>& n_down );
+  void eigenvectors( const bool& single,
+                     Matrix<fptype, Dynamic, Dynamic>& Q_up,
+                     Matrix<fptype, Dynamic, Dynamic>& Q_down );
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+// engine 0 with FixedSpins if there is a kernel for the lattice size
+bool fixed_size_available( const GlobalSettings& settings );
+
+SCCResults run_scc_fixed( const GlobalSettings& settings, const int& id,
+                          const SCCResults* start, SCCWorkspace& workspace,
+                          const SCCBound* bound = NULL,
+                          vector<TraceEvent>* trace = NULL );
+
+#endif //__SCC_FIXED_H_INCLUDED__
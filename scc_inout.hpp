@@ -21,6 +21,10 @@
 #ifndef __SCC_INOUT_H_INCLUDED__
 #define __SCC_INOUT_H_INCLUDED__
 
+#include <algorithm>
+#include <limits>
+using namespace std;
+
 #include <eigen3/Eigen/Core>
 using namespace Eigen;
 
@@ -33,6 +37,7 @@ struct SCCResults {
 
   // convergence information
   bool converged;
+  bool pruned;
   int iterations_to_convergence;
   fptype Delta_n_up, Delta_n_down;
 
@@ -40,6 +45,7 @@ struct SCCResults {
   fptype energy;
   fptype gap;
   fptype m_z;
+  fptype m_spiral;  // in-plane moment of a spin spiral (engine 3)
   fptype filling;
 
   // final mean field parameters
@@ -50,11 +56,46 @@ struct SCCResults {
   Array<fptype, Dynamic, 1> epsilon_up;
   Array<fptype, Dynamic, 1> epsilon_down;
 
-  // final eigenvectors
+  // final eigenvectors (only kept if requested by keep_eigenvectors)
   Matrix<fptype, Dynamic, Dynamic> Q_up;
   Matrix<fptype, Dynamic, Dynamic> Q_down;
 
-  SCCResults() : exit_code( 1 ) { }
+  SCCResults()
+    : exit_code( 1 ), converged( false ), pruned( false ),
+      iterations_to_convergence( 0 ),
+      Delta_n_up( 0.0 ), Delta_n_down( 0.0 ),
+      energy( 0.0 ), gap( 0.0 ), m_z( 0.0 ), m_spiral( 0.0 ),
+      filling( 0.0 ) { }
+
+  // exchange the contents with other results without copying the arrays
+  void swap( SCCResults& other ) {
+    std::swap( exit_code, other.exit_code );
+    std::swap( converged, other.converged );
+    std::swap( pruned, other.pruned );
+    std::swap( iterations_to_convergence, other.iterations_to_convergence );
+    std::swap( Delta_n_up, other.Delta_n_up );
+    std::swap( Delta_n_down, other.Delta_n_down );
+    std::swap( energy, other.energy );
+    std::swap( gap, other.gap );
+    std::swap( m_z, other.m_z );
+    std::swap( m_spiral, other.m_spiral );
+    std::swap( filling, other.filling );
+    n_up.swap( other.n_up );
+    n_down.swap( other.n_down );
+    epsilon_up.swap( other.epsilon_up );
+    epsilon_down.swap( other.epsilon_down );
+    Q_up.swap( other.Q_up );
+    Q_down.swap( other.Q_down );
+  }
+};
+
+// lowest energy of all converged calculations so far, shared by the running
+// calculations to abort the ones heading for a higher energy (only accessed
+// atomically)
+struct SCCBound {
+  fptype energy;
+
+  SCCBound() : energy( numeric_limits<fptype>::infinity() ) { }
 };
 
 #endif //__SCC_INOUT_H_INCLUDED__
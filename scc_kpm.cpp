@@ -0,0 +1,476 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "scc_kpm.hpp"
+#include "scc_calc.hpp"
+
+static void kpm_setup( KPMHamiltonian& H, const vector<int>& nb,
+                       const fptype& t, const fptype& t_prime,
+                       const Array<fptype, Dynamic, 1>& V,
+                       const int& threads )
+{
+  // find the spectral bounds of H_tb + diag( V ) from Gershgorin's theorem
+  // and rescale the Hamiltonian to the interval (-1,1)
+  const fptype radius = 4.0 * abs( t ) + 2.0 * abs( t_prime );
+  const fptype E_min = V.minCoeff() - radius;
+  const fptype E_max = V.maxCoeff() + radius;
+  H.a = 0.505 * ( E_max - E_min ) + 1e-3;
+  H.b = 0.5 * ( E_max + E_min );
+
+  H.nb = &nb;
+  for ( int bond = 0; bond < N_BONDS; ++bond ) {
+    H.bond_t[bond] = - ( bond < 4 ? t : t_prime ) / H.a;
+  }
+  H.diag = ( V - H.b ) / H.a;
+  H.threads = threads;
+}
+
+static void kpm_step( const KPMHamiltonian& H,
+                      const Array<fptype, Dynamic, 1>& x,
+                      Array<fptype, Dynamic, 1>& y, const bool& first )
+{
+  // Chebyshev recursion: y = H~ x for the first step, y = 2 H~ x - y else
+  const vector<int>& nb = *H.nb;
+  const int N = x.size();
+  #pragma omp parallel for num_threads( H.threads ) schedule( static ) \
+                           if( H.threads > 1 )
+  for ( int i = 0; i < N; ++i ) {
+    fptype Hx = H.diag( i ) * x( i );
+    for ( int bond = 0; bond < N_BONDS; ++bond ) {
+      Hx += H.bond_t[bond] * x( nb[i * N_BONDS + bond] );
+    }
+    y( i ) = first ? Hx : 2.0 * Hx - y( i );
+  }
+}
+
+static int kpm_probe_count( const int& N, const int& N_vectors,
+                            const int& probing )
+{
+  // number of probe vectors needed for one trace
+  if ( N_vectors == 0 ) {
+    return N;
+  } else {
+    return N_vectors * max( 1, probing * probing );
+  }
+}
+
+static void kpm_probe( const int& r, const int& N_vectors, const int& probing,
+                       const int& s, gsl_rng* probe_rng,
+                       Array<fptype, Dynamic, 1>& v )
+{
+  // unit vectors for exact traces, random +-1 vectors for stochastic ones
+  // (with probing the random vectors are restricted to the sites of one
+  //  colour, so that only sites further apart than the colouring period
+  //  contaminate the diagonal elements)
+  if ( N_vectors == 0 ) {
+    v.setZero();
+    v( r ) = 1.0;
+  } else if ( probing > 0 ) {
+    const int colour = r % ( probing * probing );
+    for ( int i = 0; i < v.size(); ++i ) {
+      v( i ) = 0.0;
+      if ( ( idx2y( i, s ) % probing ) * probing
+           + idx2x( i, s ) % probing == colour ) {
+        v( i ) = gsl_rng_uniform( probe_rng ) < 0.5 ? -1.0 : 1.0;
+      }
+    }
+  } else {
+    for ( int i = 0; i < v.size(); ++i ) {
+      v( i ) = gsl_rng_uniform( probe_rng ) < 0.5 ? -1.0 : 1.0;
+    }
+  }
+}
+
+static vector<double> kpm_moments( const KPMHamiltonian& H, const int& M,
+                                   const int& N_vectors, const int& probing,
+                                   const int& s, const unsigned long& probe_seed )
+{
+  // calculate the normalized moments mu_n = Tr T_n( H~ ) / N for n < M
+  // (M has to be even, two moments are obtained per recursion step)
+  const int N = H.diag.size();
+  const int N_probes = kpm_probe_count( N, N_vectors, probing );
+
+  gsl_rng* probe_rng = gsl_rng_alloc( gsl_rng_mt19937 );
+  gsl_rng_set( probe_rng, probe_seed );
+
+  vector<double> mu( M, 0.0 );
+  Array<fptype, Dynamic, 1> v_prev( N ), v_cur( N );
+  for ( int r = 0; r < N_probes; ++r ) {
+    kpm_probe( r, N_vectors, probing, s, probe_rng, v_prev );
+    kpm_step( H, v_prev, v_cur, true );
+    const double mu0 = ( v_prev * v_prev ).sum();
+    const double mu1 = ( v_cur * v_prev ).sum();
+    mu[0] += mu0;
+    mu[1] += mu1;
+    for ( int n = 1; 2 * n + 1 < M; ++n ) {
+      // v_cur = T_n v, v_prev = T_n-1 v
+      mu[2 * n] += 2.0 * ( v_cur * v_cur ).sum() - mu0;
+      kpm_step( H, v_cur, v_prev, false );
+      v_prev.swap( v_cur );
+      mu[2 * n + 1] += 2.0 * ( v_cur * v_prev ).sum() - mu1;
+    }
+  }
+  gsl_rng_free( probe_rng );
+
+  for ( int n = 0; n < M; ++n ) {
+    mu[n] /= static_cast<double>( N ) * ( N_vectors == 0 ? 1 : N_vectors );
+  }
+  return mu;
+}
+
+static vector<double> kpm_fermi_coefficients( const double& mu_t,
+                                              const double& kT_t,
+                                              const int& M,
+                                              const vector<double>& g )
+{
+  // Chebyshev coefficients of the Fermi function f( x ) on (-1,1) with the
+  // kernel factors g_n already multiplied in
+  vector<double> c( M, 0.0 );
+  if ( kT_t == 0.0 ) {
+    const double theta = acos( max( -1.0, min( 1.0, mu_t ) ) );
+    c[0] = 1.0 - theta / M_PI;
+    for ( int n = 1; n < M; ++n ) {
+      c[n] = -2.0 * sin( n * theta ) / ( n * M_PI );
+    }
+  } else {
+    // Chebyshev-Gauss quadrature
+    const int K = 2 * M;
+    for ( int k = 0; k < K; ++k ) {
+      const double theta = M_PI * ( k + 0.5 ) / K;
+      const double f = fermifunc( cos( theta ), mu_t, kT_t );
+      for ( int n = 0; n < M; ++n ) {
+        c[n] += ( n == 0 ? 1.0 : 2.0 ) * f * cos( n * theta ) / K;
+      }
+    }
+  }
+  for ( int n = 0; n < M; ++n ) {
+    c[n] *= g[n];
+  }
+  return c;
+}
+
+static double kpm_count( const vector<double>& c, const vector<double>& mu )
+{
+  // number of states per site below the chemical potential
+  double count = 0.0;
+  for ( size_t n = 0; n < c.size(); ++n ) {
+    count += c[n] * mu[n];
+  }
+  return count;
+}
+
+static double kpm_find_mu( const double& filling, const double& kT_t,
+                           const int& M, const vector<double>& g,
+                           const vector<double>& mu )
+{
+  // bisect for the (rescaled) chemical potential yielding the given filling
+  double lo = -1.0, hi = 1.0;
+  for ( int i = 0; i < 60; ++i ) {
+    const double mid = 0.5 * ( lo + hi );
+    if ( kpm_count( kpm_fermi_coefficients( mid, kT_t, M, g ), mu ) < filling ) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return 0.5 * ( lo + hi );
+}
+
+static void kpm_density( const KPMHamiltonian& H, const vector<double>& c,
+                         const int& N_vectors, const int& probing,
+                         const int& s, const unsigned long& probe_seed,
+                         Array<fptype, Dynamic, 1>& n )
+{
+  // calculate the diagonal of the Fermi operator n_i = < i | f( H~ ) | i >
+  const int N = H.diag.size();
+  const int N_probes = kpm_probe_count( N, N_vectors, probing );
+
+  gsl_rng* probe_rng = gsl_rng_alloc( gsl_rng_mt19937 );
+  gsl_rng_set( probe_rng, probe_seed );
+
+  n = Array<fptype, Dynamic, 1>::Zero( N );
+  Array<fptype, Dynamic, 1> v( N ), v_prev( N ), v_cur( N ), fv( N );
+  for ( int r = 0; r < N_probes; ++r ) {
+    kpm_probe( r, N_vectors, probing, s, probe_rng, v );
+    v_prev = v;
+    kpm_step( H, v_prev, v_cur, true );
+    fv = c[0] * v_prev + c[1] * v_cur;
+    for ( size_t m = 2; m < c.size(); ++m ) {
+      kpm_step( H, v_cur, v_prev, false );
+      v_prev.swap( v_cur );
+      fv += c[m] * v_cur;
+    }
+    n += v * fv;
+  }
+  gsl_rng_free( probe_rng );
+
+  if ( N_vectors != 0 ) {
+    n /= N_vectors;
+  }
+}
+
+SCCResults run_scc_kpm( const GlobalSettings& settings, const int& id,
+                       const SCCResults* start, vector<TraceEvent>* trace )
+{
+
+  // ----- INITIALIZATION -----
+
+  SCCResults results;
+
+  // define short names for the most used settings:
+  int const& s = settings.s;
+  fptype const& t = settings.t;
+  fptype const& t_prime = settings.t_prime;
+  fptype const& U = settings.U;
+  fptype const& m_prec = settings.m_prec;
+
+  // number of moments (rounded up to an even number) and the Jackson kernel
+  // (the energy needs one moment more than the density)
+  const int M = settings.kpm_moments + settings.kpm_moments % 2;
+  if ( M < 2 || settings.kpm_vectors < 0 || settings.kpm_probing < 0 ) {
+    #pragma omp critical (output)
+    { cerr << id << ": ERROR -> invalid Chebyshev expansion settings!" << endl; }
+    return results;
+  }
+  vector<double> g( M );
+  for ( int n = 0; n < M; ++n ) {
+    const double q = M_PI / ( M + 1 );
+    g[n] = ( ( M - n + 1 ) * cos( q * n ) + sin( q * n ) / tan( q ) ) / ( M + 1 );
+  }
+
+  // create the random number stream of this calculation
+  gsl_rng* rng = alloc_scc_rng( settings, id );
+
+  // the Fermi-Dirac start of init=2 is skipped when continuing from a
+  // given solution
+  const bool fd_start = ( settings.init == 2 && start == NULL );
+
+  // the random vectors for stochastic traces are the same in every iteration
+  const unsigned long probe_seed = gsl_rng_get( rng );
+
+  // initialize mean field parameter <n_i,sigma>
+  Array<fptype, Dynamic, 1> n_up;
+  Array<fptype, Dynamic, 1> n_down;
+  if ( init_mean_fields( settings, id, rng, n_up, n_down, start ) != 0 ) {
+    #pragma omp critical (output)
+    { cerr << id << ": ERROR -> unknown initialization!" << endl; }
+    gsl_rng_free( rng );
+    return results;
+  }
+
+  // the tight-binding part of H_sigma is only stored as a neighbour table
+  const vector<int> nb = neighbour_table( s );
+
+  // (the exact traces are used on lattices where they need no more vectors
+  //  than the stochastic ones)
+  const int N_vectors =
+    ( kpm_probe_count( s * s, settings.kpm_vectors, settings.kpm_probing )
+      < s * s ) ? settings.kpm_vectors : 0;
+
+  // threads working on this calculation: the moments of both spins are
+  // calculated concurrently and the remaining threads share the sites
+  const int threads = max( 1, settings.threads_per_scc );
+  const int spin_threads = min( 2, threads );
+  const int site_threads = max( 1, threads / spin_threads );
+
+  // save the old mean field parameters
+  Array<fptype, Dynamic, 1> n_up_old = n_up;
+  Array<fptype, Dynamic, 1> n_down_old = n_down;
+
+
+  // ----- SELF CONSISTENCY CYCLE -----
+
+  // forward declare variables needed in the SCC
+
+  KPMHamiltonian H_up, H_down;
+  vector<double> mu_up, mu_down;
+  vector<double> c_up, c_down;
+  Array<fptype, Dynamic, 1> n_up_new, n_down_new;
+
+  // history of the mixing scheme
+  MixerState mixer;
+
+  // iteration counter (an interrupted calculation continues from its
+  // checkpoint)
+  int iter = resume_checkpoint( settings, id, n_up, n_down, mixer, rng );
+
+  // set in the iteration that starts from the Fermi function at kT
+  bool fd_iter = false;
+
+  do {
+    ++iter;
+    const double t_start = trace_clock( trace );
+
+    // construct H_up and H_down from the mean field parameters <n_i,sigma>
+    kpm_setup( H_up, nb, t, t_prime, U * n_down, site_threads );
+    kpm_setup( H_down, nb, t, t_prime, U * n_up, site_threads );
+
+    // calculate the Chebyshev moments of both densities of states
+    #pragma omp parallel sections num_threads( spin_threads )
+    {
+      #pragma omp section
+      {
+        mu_up = kpm_moments( H_up, M + 2, N_vectors,
+                             settings.kpm_probing, s, probe_seed );
+      }
+      #pragma omp section
+      {
+        mu_down = kpm_moments( H_down, M + 2, N_vectors,
+                               settings.kpm_probing, s, probe_seed );
+      }
+    }
+
+    // find the chemical potentials for half filling (there are no eigenstates
+    // to draw from, so init=2 starts from the Fermi function at kT instead)
+    fd_iter = ( iter == 1 && fd_start );
+    const double kT_up = fd_iter ? settings.kT / H_up.a : 0.0;
+    const double kT_down = fd_iter ? settings.kT / H_down.a : 0.0;
+    c_up = kpm_fermi_coefficients(
+             kpm_find_mu( 0.5, kT_up, M, g, mu_up ), kT_up, M, g );
+    c_down = kpm_fermi_coefficients(
+               kpm_find_mu( 0.5, kT_down, M, g, mu_down ), kT_down, M, g );
+    const double t_solved = trace_clock( trace );
+
+    // calculate the new densities from the diagonal of the Fermi operator
+    #pragma omp parallel sections num_threads( spin_threads )
+    {
+      #pragma omp section
+      {
+        kpm_density( H_up, c_up, N_vectors, settings.kpm_probing,
+                     s, probe_seed, n_up_new );
+      }
+      #pragma omp section
+      {
+        kpm_density( H_down, c_down, N_vectors,
+                     settings.kpm_probing, s, probe_seed, n_down_new );
+      }
+    }
+
+    const double t_density = trace_clock( trace );
+
+    // save old mean field parameters
+    n_up_old = n_up;
+    n_down_old = n_down;
+
+    fptype mixing = 1.0;
+    if ( fd_iter ) {
+      // the Fermi function at kT keeps the uniform paramagnet uniform, so a
+      // weak random seed takes the place of the occupations drawn by the
+      // eigensolvers (the filling of both spins is not changed)
+      Array<fptype, Dynamic, 1> seed_up( s * s ), seed_down( s * s );
+      for ( int i = 0; i < s * s; ++i ) {
+        seed_up( i ) = 0.01 * gsl_rng_uniform( rng );
+        seed_down( i ) = 0.01 * gsl_rng_uniform( rng );
+      }
+      n_up = n_up_new + seed_up - seed_up.mean();
+      n_down = n_down_new + seed_down - seed_down.mean();
+    } else {
+      // update mean field parameters with mixing
+      mixing = mix_mean_fields( settings, mixer, rng, n_up, n_down,
+                                n_up_new, n_down_new );
+    }
+    const double t_mixed = trace_clock( trace );
+
+    // save the state of the cycle from time to time
+    if ( checkpoint_due( settings, iter ) &&
+         write_checkpoint( settings, id, iter, n_up, n_down, mixer,
+                           rng ) != 0 ) {
+      #pragma omp critical (output)
+      { cerr << id << ": WARNING -> unable to write checkpoint!" << endl; }
+    }
+
+    // (the band energy is only calculated for the final iteration)
+    if ( trace != NULL ) {
+      add_trace_event( trace, id, iter,
+                       ( n_up - n_up_old ).abs().maxCoeff(),
+                       ( n_down - n_down_old ).abs().maxCoeff(),
+                       numeric_limits<fptype>::quiet_NaN(), mixing,
+                       t_start, t_solved, t_density, t_mixed );
+    }
+
+    // (the start at kT is close to a fixed point of the map at kT, so it
+    //  never counts as converged: at least one iteration at kT=0 follows)
+  } while ( ( fd_iter
+              || ( n_up - n_up_old ).abs().maxCoeff() > m_prec
+              || ( n_down - n_down_old ).abs().maxCoeff() > m_prec )
+            && iter < settings.max_iterations );
+
+  // delete random number generator
+  gsl_rng_free( rng );
+
+
+  // ----- RESULT OUTPUT -----
+
+  results.converged = !fd_iter
+                      && ( n_up - n_up_old ).abs().maxCoeff() < m_prec
+                      && ( n_down - n_down_old ).abs().maxCoeff() < m_prec;
+  results.iterations_to_convergence = iter;
+  results.Delta_n_up = ( n_up - n_up_old ).abs().maxCoeff();
+  results.Delta_n_down = ( n_down - n_down_old ).abs().maxCoeff();
+
+  // (the energy is always the one at kT=0, also if max_iterations stopped
+  //  the cycle right after the start at kT)
+  if ( fd_iter ) {
+    c_up = kpm_fermi_coefficients( kpm_find_mu( 0.5, 0.0, M, g, mu_up ),
+                                   0.0, M, g );
+    c_down = kpm_fermi_coefficients( kpm_find_mu( 0.5, 0.0, M, g, mu_down ),
+                                     0.0, M, g );
+  }
+
+  // band energy Tr( H f( H ) ) = a Tr( H~ f( H~ ) ) + b Tr( f( H~ ) ) using
+  // x T_n( x ) = ( T_n+1( x ) + T_|n-1|( x ) ) / 2
+  results.energy = 0.0;
+  const KPMHamiltonian* H[2] = { &H_up, &H_down };
+  const vector<double>* mu[2] = { &mu_up, &mu_down };
+  const vector<double>* c[2] = { &c_up, &c_down };
+  for ( int spin = 0; spin < 2; ++spin ) {
+    double trace_xf = 0.0;
+    for ( int n = 0; n < M; ++n ) {
+      trace_xf += ( *c[spin] )[n]
+                  * 0.5 * ( ( *mu[spin] )[n + 1] + ( *mu[spin] )[abs( n - 1 )] );
+    }
+    results.energy += s * s * ( H[spin]->a * trace_xf
+                                + H[spin]->b * kpm_count( *c[spin], *mu[spin] ) );
+  }
+
+  // there are no eigenvalues: estimate the gap from the energy window in
+  // which the integrated density of states stays within one state of N/2
+  results.gap = 0.0;
+  for ( int spin = 0; spin < 2; ++spin ) {
+    const double below = 0.5 - 0.5 / ( s * s );
+    const double above = 0.5 + 0.5 / ( s * s );
+    const fptype gap = H[spin]->a * ( kpm_find_mu( above, 0.0, M, g, *mu[spin] )
+                                    - kpm_find_mu( below, 0.0, M, g, *mu[spin] ) );
+    results.gap = ( spin == 0 ? gap : min( results.gap, gap ) );
+  }
+
+  results.m_z = n_up.sum() - n_down.sum();
+  results.filling =   ( n_up.sum() + n_down.sum() )
+                    / static_cast<fptype>( s * s * 2 );
+
+  results.n_up.swap( n_up );
+  results.n_down.swap( n_down );
+
+  // (there are no eigenvalues or eigenvectors in the Chebyshev expansion)
+
+  results.exit_code = 0;
+  return results;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#ifndef __SCC_KPM_H_INCLUDED__
+#define __SCC_KPM_H_INCLUDED__
+
+#include <iostream>
+#include <cmath>
+#include <vector>
+using namespace std;
+
+#include <eigen3/Eigen/Core>
+using namespace Eigen;
+
+#include <gsl/gsl_rng.h>
+
+#include "typedefs.hpp"
+#include "settings.hpp"
+#include "lattice.hpp"
+#include "scc_inout.hpp"
+#include "mixer.hpp"
+#include "rng.hpp"
+#include "checkpoint.hpp"
+#include "trace.hpp"
+
+
+// rescaled stencil Hamiltonian H~ = ( H_tb + diag( V ) - b ) / a of one spin
+struct KPMHamiltonian {
+  const vector<int>* nb;
+  fptype bond_t[N_BONDS];
+  Array<fptype, Dynamic, 1> diag;
+  fptype a, b;
+  int threads;
+};
+
+SCCResults run_scc_kpm( const GlobalSettings& settings, const int& id,
+                       const SCCResults* start = NULL,
+                       vector<TraceEvent>* trace = NULL );
+
+#endif //__SCC_KPM_H_INCLUDED__
@@ -0,0 +1,340 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "scc_kspace.hpp"
+#include "scc_calc.hpp"
+
+// comparison of state indices by their energy (used to find occupied states)
+struct EnergyOrder {
+  const Array<fptype, Dynamic, 1>& epsilon;
+  EnergyOrder( const Array<fptype, Dynamic, 1>& eps ) : epsilon( eps ) { }
+  bool operator()( const int& a, const int& b ) const {
+    return epsilon( a ) < epsilon( b );
+  }
+};
+
+SCCResults run_scc_kspace( const GlobalSettings& settings, const int& id,
+                          const SCCResults* start, const SCCBound* bound,
+                          vector<TraceEvent>* trace )
+{
+
+  // ----- INITIALIZATION -----
+
+  SCCResults results;
+
+  // define short names for the most used settings:
+  int const& s = settings.s;
+  fptype const& t = settings.t;
+  fptype const& t_prime = settings.t_prime;
+  fptype const& U = settings.U;
+  fptype const& m_prec = settings.m_prec;
+
+  // find the magnetic unit cell
+  MagneticCell mc;
+  const int cell_status = get_magnetic_cell( settings.cell, s, mc );
+  if ( cell_status != 0 ) {
+    #pragma omp critical (output)
+    {
+      cerr << id << ": ERROR -> "
+           << ( cell_status == 1 ? "unknown magnetic unit cell!"
+                : "magnetic unit cell does not tile the lattice!" ) << endl;
+    }
+    return results;
+  }
+  const int Nc = mc.p * mc.r;  // sites per magnetic unit cell
+  const int Nk = s * s / Nc;   // number of k-points (= number of unit cells)
+  const int N_occ = s * s / 2; // occupied states per spin
+
+  // the Fermi-Dirac start of init=2 is skipped when continuing from a
+  // given solution
+  const bool fd_start = ( settings.init == 2 && start == NULL );
+
+  // create the random number stream of this calculation
+  gsl_rng* rng = alloc_scc_rng( settings, id );
+
+  // initialize the mean field parameters on the full lattice and average
+  // them over the sublattices of the magnetic unit cell
+  Array<fptype, Dynamic, 1> n_up;
+  Array<fptype, Dynamic, 1> n_down;
+  {
+    Array<fptype, Dynamic, 1> n_up_lattice;
+    Array<fptype, Dynamic, 1> n_down_lattice;
+    if ( init_mean_fields( settings, id, rng, n_up_lattice, n_down_lattice,
+                           start ) != 0 ) {
+      #pragma omp critical (output)
+      { cerr << id << ": ERROR -> unknown initialization!" << endl; }
+      gsl_rng_free( rng );
+      return results;
+    }
+    n_up   = Array<fptype, Dynamic, 1>::Zero( Nc );
+    n_down = Array<fptype, Dynamic, 1>::Zero( Nc );
+    for ( int i = 0; i < s * s; ++i ) {
+      const int a = xy2sub( idx2x( i, s ), idx2y( i, s ), mc );
+      n_up( a ) += n_up_lattice( i ) / Nk;
+      n_down( a ) += n_down_lattice( i ) / Nk;
+    }
+  }
+
+  // find one representative k = 2pi/s * (k_x,k_y) for every point of the
+  // magnetic Brillouin zone: two k-points are equivalent if their phases
+  // along both translations of the magnetic unit cell agree
+  vector< pair<int, int> > kpoints;
+  {
+    set< pair<int, int> > phases;
+    for ( int k_y = 0; k_y < s; ++k_y ) {
+      for ( int k_x = 0; k_x < s; ++k_x ) {
+        const pair<int, int> phase( ( k_x * mc.p ) % s,
+                                    ( k_x * mc.q + k_y * mc.r ) % s );
+        if ( phases.insert( phase ).second ) {
+          kpoints.push_back( make_pair( k_x, k_y ) );
+        }
+      }
+    }
+  }
+
+  // construct the Fourier transformed tight-binding part T(k) of H_sigma(k)
+  // (like H_tb in real space it only needs to be calculated once)
+  vector< Matrix<complex<fptype>, Dynamic, Dynamic> > T_k( Nk );
+  for ( int k = 0; k < Nk; ++k ) {
+    T_k[k] = Matrix<complex<fptype>, Dynamic, Dynamic>::Zero( Nc, Nc );
+    for ( int a = 0; a < Nc; ++a ) {
+      // position of the sublattice's representative site
+      const int x = a % mc.p;
+      const int y = a / mc.p;
+      for ( int bond = 0; bond < N_BONDS; ++bond ) {
+        const int b = xy2sub( x + bond_dx[bond], y + bond_dy[bond], mc );
+        const fptype phase = 2.0 * M_PI / s * ( kpoints[k].first * bond_dx[bond]
+                                            + kpoints[k].second * bond_dy[bond] );
+        T_k[k]( a, b ) -= ( bond < 4 ? t : t_prime )
+                          * polar( fptype( 1.0 ), phase );
+      }
+    }
+  }
+
+  // threads working on this calculation (they share the k-points)
+  const int threads = max( 1, settings.threads_per_scc );
+
+  // save the old mean field parameters
+  Array<fptype, Dynamic, 1> n_up_old = n_up;
+  Array<fptype, Dynamic, 1> n_down_old = n_down;
+
+
+  // ----- SELF CONSISTENCY CYCLE -----
+
+  // forward declare variables needed in the SCC
+
+  // eigenvalues and eigenvectors of all blocks (state index = k * Nc + band)
+  Array<fptype, Dynamic, 1> epsilon_up( s * s );
+  Array<fptype, Dynamic, 1> epsilon_down( s * s );
+  vector< Matrix<complex<fptype>, Dynamic, Dynamic> > Q_up( Nk );
+  vector< Matrix<complex<fptype>, Dynamic, Dynamic> > Q_down( Nk );
+
+  // state indices sorted by energy
+  vector<int> order_up( s * s );
+  vector<int> order_down( s * s );
+
+  // history of the mixing scheme
+  MixerState mixer;
+
+  // iteration counter (an interrupted calculation continues from its
+  // checkpoint)
+  int iter = resume_checkpoint( settings, id, n_up, n_down, mixer, rng );
+
+  do {
+    ++iter;
+    const double t_start = trace_clock( trace );
+
+    // construct and diagonalize H_up(k) and H_down(k) for all k
+    // (the k-points are independent and shared by the threads)
+    bool failed = false;
+    #pragma omp parallel for num_threads( threads ) schedule( dynamic ) \
+                             reduction( || : failed )
+    for ( int k = 0; k < Nk; ++k ) {
+      Matrix<complex<fptype>, Dynamic, Dynamic> H_k;
+      SelfAdjointEigenSolver< Matrix<complex<fptype>, Dynamic, Dynamic> >
+        solver;
+
+      H_k = T_k[k];
+      H_k.diagonal().real() += ( U * n_down ).matrix();
+      solver.compute( H_k );
+      if ( solver.info() == NoConvergence ) {
+        failed = true;
+        continue;
+      }
+      epsilon_up.segment( k * Nc, Nc ) = solver.eigenvalues();
+      Q_up[k] = solver.eigenvectors();
+
+      H_k = T_k[k];
+      H_k.diagonal().real() += ( U * n_up ).matrix();
+      solver.compute( H_k );
+      if ( solver.info() == NoConvergence ) {
+        failed = true;
+        continue;
+      }
+      epsilon_down.segment( k * Nc, Nc ) = solver.eigenvalues();
+      Q_down[k] = solver.eigenvectors();
+    }
+    if ( failed ) {
+      #pragma omp critical (output)
+      { cerr << id << ": ERROR -> diagonalization did not converge!" << endl; }
+      gsl_rng_free( rng );
+      return results;
+    }
+
+    // sort the states of both spins by energy
+    for ( int i = 0; i < s * s; ++i ) {
+      order_up[i] = i;
+      order_down[i] = i;
+    }
+    sort( order_up.begin(), order_up.end(), EnergyOrder( epsilon_up ) );
+    sort( order_down.begin(), order_down.end(), EnergyOrder( epsilon_down ) );
+    const double t_solved = trace_clock( trace );
+
+    // give up if this calculation is heading for a higher energy than the
+    // best one found so far
+    fptype E_band = 0.0;
+    for ( int i = 0; i < N_occ; ++i ) {
+      E_band += epsilon_up( order_up[i] ) + epsilon_down( order_down[i] );
+    }
+    if ( hopeless( settings, bound, iter, E_band ) ) {
+      gsl_rng_free( rng );
+      results.pruned = true;
+      results.iterations_to_convergence = iter;
+      results.energy = E_band;
+      results.exit_code = 0;
+      return results;
+    }
+
+    // save old mean field parameters
+    n_up_old = n_up;
+    n_down_old = n_down;
+
+    // decide which states are occupied
+    vector<bool> occupied_up( s * s, false );
+    vector<bool> occupied_down( s * s, false );
+    if ( iter == 1 && fd_start ) {
+      // calculate the fermi energy
+      fptype E_fermi = 0.5 * ( epsilon_up( order_up[N_occ - 1] ) +
+                               epsilon_down( order_down[N_occ - 1] ) );
+
+      // find occupied states according to the fermi distribution
+      occupied_up = draw_fd_occupations( epsilon_up, E_fermi, settings.kT,
+                                         N_occ, rng );
+      occupied_down = draw_fd_occupations( epsilon_down, E_fermi, settings.kT,
+                                           N_occ, rng );
+    } else {
+      for ( int i = 0; i < N_occ; ++i ) {
+        occupied_up[order_up[i]] = true;
+        occupied_down[order_down[i]] = true;
+      }
+    }
+
+    // add the contributions of the occupied Bloch states
+    Array<fptype, Dynamic, 1> n_up_new = Array<fptype, Dynamic, 1>::Zero( Nc );
+    Array<fptype, Dynamic, 1> n_down_new = Array<fptype, Dynamic, 1>::Zero( Nc );
+    for ( int k = 0; k < Nk; ++k ) {
+      for ( int band = 0; band < Nc; ++band ) {
+        if ( occupied_up[k * Nc + band] ) {
+          n_up_new += Q_up[k].col( band ).array().abs2();
+        }
+        if ( occupied_down[k * Nc + band] ) {
+          n_down_new += Q_down[k].col( band ).array().abs2();
+        }
+      }
+    }
+    n_up_new /= Nk;
+    n_down_new /= Nk;
+    const double t_density = trace_clock( trace );
+
+    fptype mixing = 1.0;
+    if ( iter == 1 && fd_start ) {
+      n_up = n_up_new;
+      n_down = n_down_new;
+    } else {
+      // update mean field parameters with mixing
+      mixing = mix_mean_fields( settings, mixer, rng, n_up, n_down,
+                                n_up_new, n_down_new );
+    }
+    const double t_mixed = trace_clock( trace );
+
+    // save the state of the cycle from time to time
+    if ( checkpoint_due( settings, iter ) &&
+         write_checkpoint( settings, id, iter, n_up, n_down, mixer,
+                           rng ) != 0 ) {
+      #pragma omp critical (output)
+      { cerr << id << ": WARNING -> unable to write checkpoint!" << endl; }
+    }
+
+    if ( trace != NULL ) {
+      add_trace_event( trace, id, iter,
+                       ( n_up - n_up_old ).abs().maxCoeff(),
+                       ( n_down - n_down_old ).abs().maxCoeff(),
+                       E_band, mixing, t_start, t_solved, t_density, t_mixed );
+    }
+
+  } while ( ( ( n_up - n_up_old ).abs().maxCoeff() > m_prec
+              || ( n_down - n_down_old ).abs().maxCoeff() > m_prec )
+            && iter < settings.max_iterations );
+
+  // delete random number generator
+  gsl_rng_free( rng );
+
+
+  // ----- RESULT OUTPUT -----
+
+  results.converged = ( n_up - n_up_old ).abs().maxCoeff() < m_prec
+                      && ( n_down - n_down_old ).abs().maxCoeff() < m_prec;
+  results.iterations_to_convergence = iter;
+  results.Delta_n_up = ( n_up - n_up_old ).abs().maxCoeff();
+  results.Delta_n_down = ( n_down - n_down_old ).abs().maxCoeff();
+
+  // sorted eigenvalues of the whole lattice
+  results.epsilon_up.resize( s * s );
+  results.epsilon_down.resize( s * s );
+  for ( int i = 0; i < s * s; ++i ) {
+    results.epsilon_up( i ) = epsilon_up( order_up[i] );
+    results.epsilon_down( i ) = epsilon_down( order_down[i] );
+  }
+
+  // mean field parameters on the whole lattice
+  results.n_up.resize( s * s );
+  results.n_down.resize( s * s );
+  for ( int i = 0; i < s * s; ++i ) {
+    const int a = xy2sub( idx2x( i, s ), idx2y( i, s ), mc );
+    results.n_up( i ) = n_up( a );
+    results.n_down( i ) = n_down( a );
+  }
+
+  results.energy = ( results.epsilon_up + results.epsilon_down )
+                   .head( N_occ ).sum();
+  results.gap = min( results.epsilon_up( N_occ + 1 )
+                                               - results.epsilon_up( N_occ ),
+                     results.epsilon_down( N_occ + 1 )
+                                             - results.epsilon_down( N_occ ) );
+  results.m_z = results.n_up.sum() - results.n_down.sum();
+  results.filling =   ( results.n_up.sum() + results.n_down.sum() )
+                    / static_cast<fptype>( s * s * 2 );
+
+  // (eigenvectors of the full lattice are never constructed in k-space)
+
+  results.exit_code = 0;
+  return results;
+}
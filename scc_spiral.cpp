@@ -0,0 +1,343 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "scc_spiral.hpp"
+#include "scc_calc.hpp"
+
+// comparison of the states ( band * Nk + k ) by their energy
+struct SpiralOrder {
+  const Array<fptype, Dynamic, 1>& lower;
+  const Array<fptype, Dynamic, 1>& upper;
+  SpiralOrder( const Array<fptype, Dynamic, 1>& l,
+               const Array<fptype, Dynamic, 1>& u ) : lower( l ), upper( u ) { }
+  fptype energy( const int& a ) const {
+    return a < lower.size() ? lower( a ) : upper( a - lower.size() );
+  }
+  bool operator()( const int& a, const int& b ) const {
+    return energy( a ) < energy( b );
+  }
+};
+
+static fptype dispersion( const fptype& t, const fptype& t_prime,
+                          const fptype& k_x, const fptype& k_y )
+{
+  // eigenvalue of the tight-binding part at the (not necessarily
+  // commensurate) momentum k
+  fptype epsilon = 0.0;
+  for ( int bond = 0; bond < N_BONDS; ++bond ) {
+    epsilon -= ( bond < 4 ? t : t_prime )
+               * cos( k_x * bond_dx[bond] + k_y * bond_dy[bond] );
+  }
+  return epsilon;
+}
+
+static int init_spiral_fields( const GlobalSettings& settings, gsl_rng* rng,
+                               const SCCResults* start,
+                               Array<fptype, Dynamic, 1>& n_up,
+                               Array<fptype, Dynamic, 1>& n_down )
+{
+  // the mean field parameters are n_up = ( <n_up>, Delta ) and
+  // n_down = ( <n_down>, Delta ), so that the mixers and checkpoints can
+  // handle them like the ones of the other engines
+
+  int const& s = settings.s;
+  const fptype n = settings.filling;
+  // largest in-plane polarization at this filling
+  const fptype Delta_max = min( n, fptype( 1.0 ) - n );
+
+  n_up.resize( 2 );
+  n_down.resize( 2 );
+
+  // continue from a given solution if there is one
+  if ( start != NULL && start->n_up.size() == s * s
+                     && start->n_down.size() == s * s ) {
+    n_up( 0 ) = start->n_up.mean();
+    n_down( 0 ) = start->n_down.mean();
+    n_up( 1 ) = start->m_spiral / ( 2.0 * s * s );
+  } else if ( settings.init == 0 ) {
+    // random cone: random z- and in-plane polarization
+    const fptype m = Delta_max * ( gsl_rng_uniform( rng ) - 0.5 );
+    n_up( 0 ) = n + m;
+    n_down( 0 ) = n - m;
+    n_up( 1 ) = Delta_max * gsl_rng_uniform( rng );
+  } else if ( settings.init == 1 ) {
+    // fully polarized planar spiral
+    n_up( 0 ) = n;
+    n_down( 0 ) = n;
+    n_up( 1 ) = Delta_max;
+  } else if ( settings.init == 2 ) {
+    // paramagnetic with a weak random in-plane seed (occupations drawn from
+    // a Fermi-Dirac distribution can not break the spin rotation symmetry)
+    n_up( 0 ) = n;
+    n_down( 0 ) = n;
+    n_up( 1 ) = 0.01 * Delta_max * gsl_rng_uniform_pos( rng );
+  } else {
+    return 1;
+  }
+  n_down( 1 ) = n_up( 1 );
+  return 0;
+}
+
+SCCResults run_scc_spiral( const GlobalSettings& settings, const int& id,
+                           const SCCResults* start, const SCCBound* bound,
+                           vector<TraceEvent>* trace )
+{
+
+  // ----- INITIALIZATION -----
+
+  SCCResults results;
+
+  // define short names for the most used settings:
+  int const& s = settings.s;
+  fptype const& U = settings.U;
+  fptype const& m_prec = settings.m_prec;
+
+  // one k-point per site and a 2x2 block per k-point
+  const int Nk = s * s;
+  const bool smeared = ( settings.smearing != 0 );
+  const fptype N_target = 2.0 * settings.filling * Nk;
+  const int N_e = int( floor( N_target + 0.5 ) );
+  if ( N_e < 0 || N_e > 2 * Nk ) {
+    #pragma omp critical (output)
+    { cerr << id << ": ERROR -> filling out of range!" << endl; }
+    return results;
+  }
+
+  // create the random number stream of this calculation
+  gsl_rng* rng = alloc_scc_rng( settings, id );
+
+  Array<fptype, Dynamic, 1> n_up;
+  Array<fptype, Dynamic, 1> n_down;
+  if ( init_spiral_fields( settings, rng, start, n_up, n_down ) != 0 ) {
+    #pragma omp critical (output)
+    { cerr << id << ": ERROR -> unknown initialization!" << endl; }
+    gsl_rng_free( rng );
+    return results;
+  }
+
+  // tight-binding energies of the up electron at k and of the down
+  // electron at k-q that it is coupled to by the spiral
+  Array<fptype, Dynamic, 1> epsilon_k( Nk );
+  Array<fptype, Dynamic, 1> epsilon_kq( Nk );
+  for ( int k = 0; k < Nk; ++k ) {
+    const fptype k_x = 2.0 * M_PI / s * ( k % s );
+    const fptype k_y = 2.0 * M_PI / s * ( k / s );
+    epsilon_k( k ) = dispersion( settings.t, settings.t_prime, k_x, k_y );
+    epsilon_kq( k ) = dispersion( settings.t, settings.t_prime,
+                                  k_x - 2.0 * M_PI * settings.spiral_qx,
+                                  k_y - 2.0 * M_PI * settings.spiral_qy );
+  }
+
+  // threads working on this calculation (they share the k-points)
+  const int threads = max( 1, settings.threads_per_scc );
+
+  // save the old mean field parameters
+  Array<fptype, Dynamic, 1> n_up_old = n_up;
+  Array<fptype, Dynamic, 1> n_down_old = n_down;
+
+
+  // ----- SELF CONSISTENCY CYCLE -----
+
+  // forward declare variables needed in the SCC
+
+  // eigenvalues of the blocks and the mixing angle of their eigenvectors:
+  // the lower state is ( sqrt( 1 - c ), -sign( b ) sqrt( 1 + c ) ) / sqrt2
+  // with c = cos( theta ), b = sin( theta ) of the block
+  Array<fptype, Dynamic, 1> lower( Nk );
+  Array<fptype, Dynamic, 1> upper( Nk );
+  Array<fptype, Dynamic, 1> cos_theta( Nk );
+  Array<fptype, Dynamic, 1> sin_theta( Nk );
+
+  // occupations of the states
+  Array<fptype, Dynamic, 1> w_lower( Nk );
+  Array<fptype, Dynamic, 1> w_upper( Nk );
+
+  // state indices ( band * Nk + k ) sorted by energy
+  vector<int> order( 2 * Nk );
+
+  fptype mu = 0.0;
+  fptype E_band = 0.0;
+
+  // history of the mixing scheme
+  MixerState mixer;
+
+  // iteration counter (an interrupted calculation continues from its
+  // checkpoint)
+  int iter = resume_checkpoint( settings, id, n_up, n_down, mixer, rng );
+
+  do {
+    ++iter;
+    const double t_start = trace_clock( trace );
+
+    // solve the blocks
+    // ( eps(k) + U <n_down>      -U Delta        )
+    // ( -U Delta                 eps(k-q) + U <n_up> )
+    #pragma omp parallel for num_threads( threads )
+    for ( int k = 0; k < Nk; ++k ) {
+      const fptype a = epsilon_k( k ) + U * n_down( 0 );
+      const fptype c = epsilon_kq( k ) + U * n_up( 0 );
+      const fptype b = -U * n_up( 1 );
+      const fptype d = 0.5 * ( a - c );
+      const fptype r = sqrt( d * d + b * b );
+      lower( k ) = 0.5 * ( a + c ) - r;
+      upper( k ) = 0.5 * ( a + c ) + r;
+      cos_theta( k ) = ( r > 0.0 ) ? d / r : -1.0;
+      sin_theta( k ) = ( r > 0.0 ) ? b / r : 0.0;
+    }
+    const double t_solved = trace_clock( trace );
+
+    // occupy the states of both bands up to a common chemical potential
+    if ( smeared ) {
+      const fptype width = smearing_width( settings, iter );
+      if ( find_chemical_potential( settings.smearing, width, lower, upper,
+                                    N_target, mu ) != 0 ) {
+        #pragma omp critical (output)
+        { cerr << id << ": ERROR -> filling out of range!" << endl; }
+        gsl_rng_free( rng );
+        return results;
+      }
+      for ( int k = 0; k < Nk; ++k ) {
+        w_lower( k ) = smeared_occupation( settings.smearing,
+                                           ( lower( k ) - mu ) / width );
+        w_upper( k ) = smeared_occupation( settings.smearing,
+                                           ( upper( k ) - mu ) / width );
+      }
+    } else {
+      for ( int i = 0; i < 2 * Nk; ++i ) {
+        order[i] = i;
+      }
+      sort( order.begin(), order.end(), SpiralOrder( lower, upper ) );
+      w_lower.setZero();
+      w_upper.setZero();
+      for ( int i = 0; i < N_e; ++i ) {
+        if ( order[i] < Nk ) {
+          w_lower( order[i] ) = 1.0;
+        } else {
+          w_upper( order[i] - Nk ) = 1.0;
+        }
+      }
+    }
+    E_band = ( w_lower * lower + w_upper * upper ).sum();
+
+    // give up if this calculation is heading for a higher energy than the
+    // best one found so far
+    if ( hopeless( settings, bound, iter, E_band ) ) {
+      gsl_rng_free( rng );
+      results.pruned = true;
+      results.iterations_to_convergence = iter;
+      results.energy = E_band;
+      results.exit_code = 0;
+      return results;
+    }
+
+    // save old mean field parameters
+    n_up_old = n_up;
+    n_down_old = n_down;
+
+    // add the contributions of the occupied states
+    fptype n_up_sum = 0.0;
+    fptype n_down_sum = 0.0;
+    fptype Delta_sum = 0.0;
+    #pragma omp parallel for num_threads( threads ) \
+                             reduction( + : n_up_sum, n_down_sum, Delta_sum )
+    for ( int k = 0; k < Nk; ++k ) {
+      n_up_sum += w_lower( k ) * ( 1.0 - cos_theta( k ) )
+                  + w_upper( k ) * ( 1.0 + cos_theta( k ) );
+      n_down_sum += w_lower( k ) * ( 1.0 + cos_theta( k ) )
+                    + w_upper( k ) * ( 1.0 - cos_theta( k ) );
+      Delta_sum += ( w_upper( k ) - w_lower( k ) ) * sin_theta( k );
+    }
+    Array<fptype, Dynamic, 1> n_up_new( 2 );
+    Array<fptype, Dynamic, 1> n_down_new( 2 );
+    n_up_new( 0 ) = 0.5 * n_up_sum / Nk;
+    n_down_new( 0 ) = 0.5 * n_down_sum / Nk;
+    n_up_new( 1 ) = 0.5 * Delta_sum / Nk;
+    n_down_new( 1 ) = n_up_new( 1 );
+    const double t_density = trace_clock( trace );
+
+    // update mean field parameters with mixing
+    const fptype mixing = mix_mean_fields( settings, mixer, rng, n_up, n_down,
+                                           n_up_new, n_down_new );
+    const double t_mixed = trace_clock( trace );
+
+    // save the state of the cycle from time to time
+    if ( checkpoint_due( settings, iter ) &&
+         write_checkpoint( settings, id, iter, n_up, n_down, mixer,
+                           rng ) != 0 ) {
+      #pragma omp critical (output)
+      { cerr << id << ": WARNING -> unable to write checkpoint!" << endl; }
+    }
+
+    if ( trace != NULL ) {
+      add_trace_event( trace, id, iter,
+                       ( n_up - n_up_old ).abs().maxCoeff(),
+                       ( n_down - n_down_old ).abs().maxCoeff(),
+                       E_band, mixing, t_start, t_solved, t_density, t_mixed );
+    }
+
+  } while ( ( ( n_up - n_up_old ).abs().maxCoeff() > m_prec
+              || ( n_down - n_down_old ).abs().maxCoeff() > m_prec
+              || ( smeared && !smearing_annealed( settings, iter ) ) )
+            && iter < settings.max_iterations );
+
+  // delete random number generator
+  gsl_rng_free( rng );
+
+
+  // ----- RESULT OUTPUT -----
+
+  results.converged = ( n_up - n_up_old ).abs().maxCoeff() < m_prec
+                      && ( n_down - n_down_old ).abs().maxCoeff() < m_prec
+                      && ( !smeared || smearing_annealed( settings, iter ) );
+  results.iterations_to_convergence = iter;
+  results.Delta_n_up = ( n_up - n_up_old ).abs().maxCoeff();
+  results.Delta_n_down = ( n_down - n_down_old ).abs().maxCoeff();
+
+  // sorted eigenvalues of the lower and upper band
+  // (the states are not eigenstates of S_z, so they take the place of the
+  //  eigenvalues of up and down)
+  results.epsilon_up = lower;
+  results.epsilon_down = upper;
+  sort( results.epsilon_up.data(), results.epsilon_up.data() + Nk );
+  sort( results.epsilon_down.data(), results.epsilon_down.data() + Nk );
+
+  // densities on the whole lattice (the in-plane spin density rotates with
+  // exp( i q.r_i ) and is only kept as m_spiral)
+  results.n_up = Array<fptype, Dynamic, 1>::Constant( Nk, n_up( 0 ) );
+  results.n_down = Array<fptype, Dynamic, 1>::Constant( Nk, n_down( 0 ) );
+
+  results.energy = E_band;
+  if ( smeared ) {
+    results.gap = gap_at( mu, lower, upper );
+  } else if ( N_e > 0 && N_e < 2 * Nk ) {
+    const SpiralOrder energy_of( lower, upper );
+    results.gap = energy_of.energy( order[N_e] )
+                  - energy_of.energy( order[N_e - 1] );
+  }
+  results.m_z = results.n_up.sum() - results.n_down.sum();
+  results.m_spiral = 2.0 * abs( n_up( 1 ) ) * Nk;
+  results.filling =   ( results.n_up.sum() + results.n_down.sum() )
+                    / static_cast<fptype>( s * s * 2 );
+
+  // (eigenvectors of the full lattice are never constructed for a spiral)
+
+  results.exit_code = 0;
+  return results;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "seeds.hpp"
+
+// (the cells are spanned by (p,0) and (q,r), the sublattice index is
+//  y_cell * p + x_cell like in xy2sub)
+const SeedPattern seed_patterns[] = {
+  // ferromagnet
+  { "ferro",           { 1, 0, 1 }, { 1.0 } },
+  // stripes in the three directions of the triangular lattice
+  // (stripe_diagonal is the checkerboard of init=1)
+  { "stripe_x",        { 2, 0, 1 }, { 1.0, -1.0 } },
+  { "stripe_y",        { 1, 0, 2 }, { 1.0, -1.0 } },
+  { "stripe_diagonal", { 2, 1, 1 }, { 1.0, -1.0 } },
+  // sqrt3 x sqrt3: ferrimagnetic up-up-down and the collinear remnant of the
+  // 120 degree order with one unpolarized sublattice
+  { "uud",             { 3, 1, 1 }, { 1.0, 1.0, -1.0 } },
+  { "ud0",             { 3, 1, 1 }, { 1.0, -1.0, 0.0 } },
+  // 2x2 cell with one of four moments flipped
+  { "ferri_2x2",       { 2, 0, 2 }, { 1.0, 1.0, 1.0, -1.0 } },
+  // up-up-down-down along x
+  { "double_stripe",   { 4, 0, 1 }, { 1.0, 1.0, -1.0, -1.0 } }
+};
+
+const int N_SEED_PATTERNS = sizeof( seed_patterns ) / sizeof( SeedPattern );
+
+int seed_pattern( const GlobalSettings& settings, const int& id )
+{
+  // weights of the patterns (missing entries of pattern_weights count as 1,
+  // patterns that do not tile the lattice as 0)
+  vector<fptype> weight( N_SEED_PATTERNS, 0.0 );
+  fptype total = 0.0;
+  for ( int k = 0; k < N_SEED_PATTERNS; ++k ) {
+    if ( cell_tiles( seed_patterns[k].mc, settings.s ) ) {
+      weight[k] = ( k < int( settings.pattern_weights.size() ) )
+                  ? max( fptype( 0.0 ), settings.pattern_weights[k] ) : 1.0;
+      total += weight[k];
+    }
+  }
+  if ( total <= 0.0 ) {
+    return -1;
+  }
+
+  // every turn the pattern furthest behind its share is picked
+  vector<fptype> current( N_SEED_PATTERNS, 0.0 );
+  int picked = -1;
+  for ( int turn = 0; turn <= id; ++turn ) {
+    picked = -1;
+    for ( int k = 0; k < N_SEED_PATTERNS; ++k ) {
+      if ( weight[k] > 0.0 ) {
+        current[k] += weight[k];
+        if ( picked < 0 || current[k] > current[picked] ) {
+          picked = k;
+        }
+      }
+    }
+    current[picked] -= total;
+  }
+  return picked;
+}
+
+int seed_mean_fields( const GlobalSettings& settings, const int& id,
+                      gsl_rng* rng,
+                      Array<fptype, Dynamic, 1>& n_up,
+                      Array<fptype, Dynamic, 1>& n_down )
+{
+  int const& s = settings.s;
+
+  const int k = seed_pattern( settings, id );
+  if ( k < 0 ) {
+    return 1;
+  }
+  const SeedPattern& pattern = seed_patterns[k];
+
+  // full polarization at this filling
+  const fptype n = settings.filling;
+  const fptype m = min( n, fptype( 1.0 ) - n );
+
+  n_up.resize( s * s );
+  n_down.resize( s * s );
+  for ( int i = 0; i < s * s; ++i ) {
+    const fptype moment =
+      pattern.moment[xy2sub( idx2x( i, s ), idx2y( i, s ), pattern.mc )];
+    n_up( i ) = n + m * moment
+                + settings.pattern_noise * ( gsl_rng_uniform( rng ) - 0.5 );
+    n_down( i ) = n - m * moment
+                  + settings.pattern_noise * ( gsl_rng_uniform( rng ) - 0.5 );
+  }
+  n_up = n_up.max( 0.0 ).min( 1.0 );
+  n_down = n_down.max( 0.0 ).min( 1.0 );
+
+  return 0;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __SEEDS_H_INCLUDED__
+#define __SEEDS_H_INCLUDED__
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+#include <eigen3/Eigen/Core>
+using namespace Eigen;
+
+#include <gsl/gsl_rng.h>
+
+#include "typedefs.hpp"
+#include "settings.hpp"
+#include "lattice.hpp"
+
+
+// ordered states of the seed library (init=3): the magnetic unit cell and
+// the z-moment of each of its sublattices relative to the full polarization
+struct SeedPattern {
+  const char* name;
+  MagneticCell mc;
+  fptype moment[4];
+};
+
+extern const SeedPattern seed_patterns[];
+extern const int N_SEED_PATTERNS;
+
+// index of the pattern used by calculation id: the patterns that tile the
+// lattice take turns in proportion to settings.pattern_weights (smooth
+// weighted round robin, so that a few calculations already cover them all),
+// returns -1 if no pattern is left
+int seed_pattern( const GlobalSettings& settings, const int& id );
+
+// initialize the mean field parameters of calculation id with its pattern,
+// perturbed by uniform noise of the amplitude settings.pattern_noise
+int seed_mean_fields( const GlobalSettings& settings, const int& id,
+                      gsl_rng* rng,
+                      Array<fptype, Dynamic, 1>& n_up,
+                      Array<fptype, Dynamic, 1>& n_down );
+
+#endif //__SEEDS_H_INCLUDED__
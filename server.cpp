@@ -0,0 +1,560 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "server.hpp"
+
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// fields of a job with their values as they would be written on the
+// command line (the entries of lists are joined by commas)
+typedef vector< pair<string, string> > JobFields;
+
+static size_t skip_space( const string& line, size_t i )
+{
+  while ( i < line.size() && isspace( static_cast<unsigned char>( line[i] ) ) ) {
+    ++i;
+  }
+  return i;
+}
+
+static void put_utf8( string& value, const unsigned long& c )
+{
+  // code point c encoded as UTF-8
+  if ( c < 0x80 ) {
+    value += char( c );
+  } else if ( c < 0x800 ) {
+    value += char( 0xc0 | ( c >> 6 ) );
+    value += char( 0x80 | ( c & 0x3f ) );
+  } else if ( c < 0x10000 ) {
+    value += char( 0xe0 | ( c >> 12 ) );
+    value += char( 0x80 | ( ( c >> 6 ) & 0x3f ) );
+    value += char( 0x80 | ( c & 0x3f ) );
+  } else {
+    value += char( 0xf0 | ( c >> 18 ) );
+    value += char( 0x80 | ( ( c >> 12 ) & 0x3f ) );
+    value += char( 0x80 | ( ( c >> 6 ) & 0x3f ) );
+    value += char( 0x80 | ( c & 0x3f ) );
+  }
+}
+
+static int parse_hex4( const string& line, const size_t& i,
+                       unsigned long& c )
+{
+  // the four hex digits of a \u escape starting at line[i]
+  if ( i + 4 > line.size() ) {
+    return 1;
+  }
+  for ( size_t j = i; j < i + 4; ++j ) {
+    if ( !isxdigit( static_cast<unsigned char>( line[j] ) ) ) {
+      return 1;
+    }
+  }
+  c = strtoul( line.substr( i, 4 ).c_str(), NULL, 16 );
+  return 0;
+}
+
+static int parse_string( const string& line, size_t& i, string& value )
+{
+  // JSON string starting at the quote line[i]
+  value.clear();
+  for ( ++i; i < line.size() && line[i] != '"'; ++i ) {
+    if ( line[i] != '\\' ) {
+      value += line[i];
+      continue;
+    }
+    if ( ++i >= line.size() ) {
+      return 1;
+    }
+    const char e = line[i];
+    if ( e == '"' || e == '\\' || e == '/' ) {
+      value += e;
+    } else if ( e == 'b' ) {
+      value += '\b';
+    } else if ( e == 'f' ) {
+      value += '\f';
+    } else if ( e == 'n' ) {
+      value += '\n';
+    } else if ( e == 'r' ) {
+      value += '\r';
+    } else if ( e == 't' ) {
+      value += '\t';
+    } else if ( e == 'u' ) {
+      unsigned long c;
+      if ( parse_hex4( line, i + 1, c ) != 0 ) {
+        return 1;
+      }
+      i += 4;
+      // (characters outside the basic plane come as a surrogate pair)
+      unsigned long low;
+      if ( c >= 0xd800 && c < 0xdc00 && i + 2 < line.size()
+           && line[i + 1] == '\\' && line[i + 2] == 'u'
+           && parse_hex4( line, i + 3, low ) == 0
+           && low >= 0xdc00 && low < 0xe000 ) {
+        c = 0x10000 + ( ( c - 0xd800 ) << 10 ) + ( low - 0xdc00 );
+        i += 6;
+      }
+      put_utf8( value, c );
+    } else {
+      return 1;
+    }
+  }
+  if ( i >= line.size() ) {
+    return 1;
+  }
+  ++i;
+  return 0;
+}
+
+static int parse_scalar( const string& line, size_t& i, string& value )
+{
+  // number, true, false or null: everything up to the next delimiter
+  size_t end = line.find_first_of( ",]} \t\r", i );
+  if ( end == string::npos ) {
+    end = line.size();
+  }
+  value = line.substr( i, end - i );
+  i = end;
+  if ( value == "true" ) {
+    value = "1";
+  } else if ( value == "false" ) {
+    value = "0";
+  }
+  return value.empty() ? 1 : 0;
+}
+
+static int parse_value( const string& line, size_t& i, string& value,
+                        string& raw )
+{
+  // a string, scalar or list of them, raw is the JSON text of the value
+  const size_t begin = i;
+  if ( line[i] == '"' ) {
+    if ( parse_string( line, i, value ) != 0 ) {
+      return 1;
+    }
+  } else if ( line[i] == '[' ) {
+    value.clear();
+    i = skip_space( line, i + 1 );
+    while ( i < line.size() && line[i] != ']' ) {
+      string entry;
+      const int status = ( line[i] == '"' ) ? parse_string( line, i, entry )
+                                            : parse_scalar( line, i, entry );
+      if ( status != 0 ) {
+        return 1;
+      }
+      value += ( value.empty() ? "" : "," ) + entry;
+      i = skip_space( line, i );
+      if ( i < line.size() && line[i] == ',' ) {
+        i = skip_space( line, i + 1 );
+      } else if ( i >= line.size() || line[i] != ']' ) {
+        return 1;
+      }
+    }
+    if ( i >= line.size() ) {
+      return 1;
+    }
+    ++i;
+  } else if ( parse_scalar( line, i, value ) != 0 ) {
+    return 1;
+  }
+  raw = line.substr( begin, i - begin );
+  return 0;
+}
+
+static string json_string( const string& value )
+{
+  // value as a JSON string with the quotes, backslashes and control
+  // characters escaped
+  string out = "\"";
+  for ( size_t i = 0; i < value.size(); ++i ) {
+    const unsigned char c = value[i];
+    if ( c == '"' || c == '\\' ) {
+      out += '\\';
+      out += c;
+    } else if ( c < 0x20 ) {
+      char escaped[8];
+      sprintf( escaped, "\\u%04x", c );
+      out += escaped;
+    } else {
+      out += c;
+    }
+  }
+  return out + "\"";
+}
+
+static bool json_number_text( const string& text )
+{
+  // -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+  size_t i = 0;
+  if ( i < text.size() && text[i] == '-' ) {
+    ++i;
+  }
+  if ( i >= text.size() || !isdigit( static_cast<unsigned char>( text[i] ) ) ) {
+    return false;
+  }
+  if ( text[i] == '0' ) {
+    ++i;
+  } else {
+    while ( i < text.size() && isdigit( static_cast<unsigned char>( text[i] ) ) ) {
+      ++i;
+    }
+  }
+  if ( i < text.size() && text[i] == '.' ) {
+    const size_t digits = ++i;
+    while ( i < text.size() && isdigit( static_cast<unsigned char>( text[i] ) ) ) {
+      ++i;
+    }
+    if ( i == digits ) {
+      return false;
+    }
+  }
+  if ( i < text.size() && ( text[i] == 'e' || text[i] == 'E' ) ) {
+    ++i;
+    if ( i < text.size() && ( text[i] == '+' || text[i] == '-' ) ) {
+      ++i;
+    }
+    const size_t digits = i;
+    while ( i < text.size() && isdigit( static_cast<unsigned char>( text[i] ) ) ) {
+      ++i;
+    }
+    if ( i == digits ) {
+      return false;
+    }
+  }
+  return i == text.size();
+}
+
+static int parse_job( const string& line, JobFields& fields, string& id )
+{
+  // flat JSON object { "name": value, ... }, the id is kept as JSON text to
+  // be sent back (returns 2 if the id is not a string or a number)
+  fields.clear();
+  id = "null";
+  size_t i = skip_space( line, 0 );
+  if ( i >= line.size() || line[i] != '{' ) {
+    return 1;
+  }
+  i = skip_space( line, i + 1 );
+  if ( i < line.size() && line[i] == '}' ) {
+    return 0;
+  }
+  while ( i < line.size() && line[i] == '"' ) {
+    string name, value, raw;
+    if ( parse_string( line, i, name ) != 0 ) {
+      return 1;
+    }
+    i = skip_space( line, i );
+    if ( i >= line.size() || line[i] != ':' ) {
+      return 1;
+    }
+    i = skip_space( line, i + 1 );
+    if ( i >= line.size() || parse_value( line, i, value, raw ) != 0 ) {
+      return 1;
+    }
+    if ( name == "id" ) {
+      if ( raw[0] == '"' ) {
+        id = json_string( value );
+      } else if ( json_number_text( raw ) ) {
+        id = raw;
+      } else {
+        return 2;
+      }
+    } else {
+      fields.push_back( make_pair( name, value ) );
+    }
+    i = skip_space( line, i );
+    if ( i < line.size() && line[i] == '}' ) {
+      return 0;
+    } else if ( i < line.size() && line[i] == ',' ) {
+      i = skip_space( line, i + 1 );
+    } else {
+      return 1;
+    }
+  }
+  return 1;
+}
+
+static int apply_job( const GlobalSettings& base, const JobFields& fields,
+                      GlobalSettings& settings, string& error )
+{
+  settings = base;
+
+  // t_prime and U are relative to t and m_prec is per site like on the
+  // command line
+  fptype t_prime = base.t_prime / base.t;
+  fptype U = base.U / base.t;
+  fptype m_prec = base.m_prec / ( base.s * base.s );
+
+  for ( size_t f = 0; f < fields.size(); ++f ) {
+    const string& name = fields[f].first;
+    const char* value = fields[f].second.c_str();
+    if ( name == "s" ) {
+      settings.s = atoi( value );
+    } else if ( name == "t" ) {
+      settings.t = atof( value );
+    } else if ( name == "t_prime" ) {
+      t_prime = atof( value );
+    } else if ( name == "U" ) {
+      U = atof( value );
+    } else if ( name == "N_SCC" ) {
+      settings.N_SCC = atoi( value );
+    } else if ( name == "m_prec" ) {
+      m_prec = atof( value );
+    } else if ( name == "max_iterations" ) {
+      settings.max_iterations = atoi( value );
+    } else if ( name == "init" ) {
+      settings.init = atoi( value );
+    } else if ( name == "kT" ) {
+      settings.kT = atof( value );
+    } else if ( name == "plotmode" ) {
+      // (nothing is plotted by the server)
+    } else if ( set_option( settings, name, fields[f].second ) != 0 ) {
+      error = "unknown option " + name;
+      return 1;
+    }
+  }
+  settings.t_prime = t_prime * settings.t;
+  settings.U = U * settings.t;
+  settings.m_prec = m_prec * settings.s * settings.s;
+
+  if ( settings.s <= 0 || settings.N_SCC < 0 ) {
+    error = "invalid lattice size or number of calculations";
+    return 1;
+  }
+  if ( !settings.sweep_t_prime.empty() || !settings.sweep_U.empty() ) {
+    error = "sweeps are not available as jobs";
+    return 1;
+  }
+
+  // the results only go back to the client
+  settings.plotmode = 0;
+  settings.keep_eigenvectors = 0;
+  settings.store_all = 0;
+  settings.trace = 0;
+  settings.checkpoint = 0;
+  settings.resume = 0;
+  settings.checkpoint_prefix.clear();
+  settings.serve.clear();
+  return 0;
+}
+
+static string json_number( const fptype& x )
+{
+  // (JSON has no infinities and NaNs)
+  if ( !( x == x ) || abs( x ) > numeric_limits<fptype>::max() ) {
+    return "null";
+  }
+  stringstream out;
+  out << setprecision( 12 ) << x;
+  return out.str();
+}
+
+static string json_array( const Array<fptype, Dynamic, 1>& a )
+{
+  string out = "[";
+  for ( int i = 0; i < a.size(); ++i ) {
+    out += ( i == 0 ? "" : "," ) + json_number( a( i ) );
+  }
+  return out + "]";
+}
+
+static string error_response( const string& id, const string& error )
+{
+  return "{\"id\":" + id + ",\"status\":\"error\",\"error\":"
+         + json_string( error ) + "}";
+}
+
+static string run_job( const GlobalSettings& base, const string& line,
+                       vector<SCCWorkspace>& workspaces )
+{
+  JobFields fields;
+  string id;
+  const int parsed = parse_job( line, fields, id );
+  if ( parsed == 2 ) {
+    return error_response( id, "the id has to be a string or a number" );
+  } else if ( parsed != 0 ) {
+    return error_response( id, "malformed job" );
+  }
+  GlobalSettings settings;
+  string error;
+  if ( apply_job( base, fields, settings, error ) != 0 ) {
+    return error_response( id, error );
+  }
+
+  // (a job may ask for more threads than the ones before)
+  if ( int( workspaces.size() ) < max_threads( settings ) ) {
+    workspaces.resize( max_threads( settings ) );
+  }
+
+  SCCResults gs;
+  RestartStats stats;
+  const int status = run_restarts( settings, "", vector<const SCCResults*>(),
+                                   workspaces, false, gs, &stats );
+  if ( status == 2 ) {
+    return error_response( id, "calculation failed" );
+  }
+
+  stringstream out;
+  out << "{\"id\":" << id << ",\"status\":\"ok\",\"converged\":"
+      << ( status == 0 ? "true" : "false" );
+  if ( status == 0 ) {
+    out << ",\"iterations\":" << gs.iterations_to_convergence
+        << ",\"energy\":" << json_number( gs.energy )
+        << ",\"gap\":" << json_number( gs.gap )
+        << ",\"m_z\":" << json_number( gs.m_z );
+    if ( settings.engine == 3 ) {
+      out << ",\"m_spiral\":" << json_number( gs.m_spiral );
+    }
+    out << ",\"filling\":" << json_number( gs.filling )
+        << ",\"n_up\":" << json_array( gs.n_up )
+        << ",\"n_down\":" << json_array( gs.n_down );
+  }
+  out << ",\"basins\":" << stats.basins.size()
+      << ",\"pruned\":" << stats.pruned
+      << ",\"skipped\":" << stats.skipped << "}";
+  return out.str();
+}
+
+static int write_all( const int& fd, const string& text )
+{
+  size_t done = 0;
+  while ( done < text.size() ) {
+    const ssize_t n = write( fd, text.data() + done, text.size() - done );
+    if ( n < 0 && errno == EINTR ) {
+      continue;
+    }
+    if ( n <= 0 ) {
+      return 1;
+    }
+    done += n;
+  }
+  return 0;
+}
+
+static int serve_stream( const GlobalSettings& settings, const int& in,
+                         const int& out, vector<SCCWorkspace>& workspaces )
+{
+  // answer the jobs line by line until the input ends
+  string buffer;
+  bool end_of_input = false;
+  while ( !end_of_input || !buffer.empty() ) {
+    size_t newline = buffer.find( '\n' );
+    if ( newline == string::npos && !end_of_input ) {
+      char chunk[4096];
+      const ssize_t n = read( in, chunk, sizeof( chunk ) );
+      if ( n < 0 && errno == EINTR ) {
+        continue;
+      }
+      if ( n <= 0 ) {
+        end_of_input = true;
+      } else {
+        buffer.append( chunk, n );
+      }
+      continue;
+    }
+    // (the last line does not need a newline)
+    if ( newline == string::npos ) {
+      newline = buffer.size();
+    }
+    const string line = buffer.substr( 0, newline );
+    buffer.erase( 0, min( newline + 1, buffer.size() ) );
+    if ( skip_space( line, 0 ) == line.size() ) {
+      continue;
+    }
+    if ( write_all( out, run_job( settings, line, workspaces ) + "\n" ) != 0 ) {
+      // (the client is gone)
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int serve_socket( const GlobalSettings& settings,
+                         vector<SCCWorkspace>& workspaces )
+{
+  // answer the connections to the socket one after the other
+  const string& path = settings.serve;
+  sockaddr_un address;
+  memset( &address, 0, sizeof( address ) );
+  address.sun_family = AF_UNIX;
+  if ( path.size() >= sizeof( address.sun_path ) ) {
+    cerr << "ERROR: socket path too long!" << endl;
+    return 1;
+  }
+  strcpy( address.sun_path, path.c_str() );
+
+  const int listener = socket( AF_UNIX, SOCK_STREAM, 0 );
+  // (a socket left behind by an earlier server is replaced)
+  unlink( path.c_str() );
+  if ( listener < 0
+       || bind( listener, reinterpret_cast<sockaddr*>( &address ),
+                sizeof( address ) ) != 0
+       || listen( listener, 16 ) != 0 ) {
+    cerr << "ERROR: unable to listen on " << path << ": "
+         << strerror( errno ) << endl;
+    return 1;
+  }
+  cerr << "Listening on " << path << " ..." << endl;
+
+  while ( true ) {
+    const int connection = accept( listener, NULL, NULL );
+    if ( connection < 0 ) {
+      if ( errno == EINTR ) {
+        continue;
+      }
+      cerr << "ERROR: accept failed: " << strerror( errno ) << endl;
+      break;
+    }
+    serve_stream( settings, connection, connection, workspaces );
+    close( connection );
+  }
+
+  close( listener );
+  unlink( path.c_str() );
+  return 1;
+}
+
+int run_server( const GlobalSettings& settings )
+{
+  if ( mpi_size() > 1 ) {
+    cerr << "ERROR: the server mode runs on a single process!" << endl;
+    return 1;
+  }
+
+  // (a client that goes away must not kill the server)
+  signal( SIGPIPE, SIG_IGN );
+
+  vector<SCCWorkspace> workspaces( max_threads( settings ) );
+  if ( settings.serve == "-" ) {
+    return serve_stream( settings, STDIN_FILENO, STDOUT_FILENO, workspaces );
+  }
+  return serve_socket( settings, workspaces );
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __SERVER_H_INCLUDED__
+#define __SERVER_H_INCLUDED__
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "typedefs.hpp"
+#include "settings.hpp"
+#include "scc_inout.hpp"
+#include "scc_calc.hpp"
+#include "driver.hpp"
+#include "distributed.hpp"
+
+
+// server mode (--serve): the jobs are read as one flat JSON object per line,
+// e.g. {"id": 7, "s": 10, "t_prime": 0.5, "U": 4, "N_SCC": 8, "init": 3}
+// where the keys are the positional arguments and the optional settings
+// with the same meaning as on the command line (missing ones keep the
+// values the server was started with); the ground state candidate of every
+// job is written back as a JSON line as soon as the job is finished. The
+// jobs run one after the other on all threads, which keep their workspaces
+// (tight-binding Hamiltonian, ...) from one job to the next.
+int run_server( const GlobalSettings& settings );
+
+#endif //__SERVER_H_INCLUDED__
@@ -20,6 +20,9 @@
 
 #include "settings.hpp"
 
+#include <cstdlib>
+#include <sstream>
+
 GlobalSettings get_precompiled_settings()
 {
   GlobalSettings settings;
@@ -50,8 +53,123 @@ GlobalSettings get_precompiled_settings()
   // 0: random (0,1)
   // 1: checkerboard
   // 2: paramagnetic + initial FD dist
+  // 3: ordered patterns of the seed library (seeds.cpp) taking turns in
+  //    proportion to pattern_weights (empty: equal), with uniform noise of
+  //    the amplitude pattern_noise
   settings.init = 2;
   settings.kT = 0.25;
+  settings.pattern_weights.clear();
+  settings.pattern_noise = 0.05;
+
+  // random numbers: the stream of every calculation is keyed by the seed
+  // (0: from the clock) and only the calculation only_scc is run if it is
+  // not negative, so that it can be repeated in isolation
+  settings.seed = 0;
+  settings.only_scc = -1;
+
+  // occupations of the eigenstates (engine 0 with eigensolver 0, engine 3):
+  // 0: the lowest half of the states of every spin (T=0, half filling; in
+  //    engine 3 the lowest states of both spiral bands at the filling)
+  // 1: Fermi-Dirac of width smearing_width around the chemical potential
+  //    of both spins that gives the filling (electrons per site and spin)
+  // 2: Methfessel-Paxton of first order, as 1 otherwise
+  // the width is reduced by the factor smearing_anneal per iteration down
+  // to smearing_final (1: no annealing)
+  settings.smearing = 0;
+  settings.smearing_width = 0.05;
+  settings.smearing_anneal = 1.0;
+  settings.smearing_final = 1e-3;
+  settings.filling = 0.5;
+
+  // solver engine:
+  // 0: diagonalize the full real space Hamiltonian
+  // 1: Bloch blocks of a magnetic unit cell in momentum space
+  // 2: Chebyshev expansion of the Fermi operator (no diagonalization)
+  // 3: non-collinear single-q spin spiral, 2x2 blocks in momentum space
+  //    (only uniform densities and a uniform spiral amplitude, there is no
+  //     real space mode with non-collinear fields on every site)
+  settings.engine = 0;
+
+  // magnetic unit cell for engine 1 (number of sites):
+  // 1: ferro-/paramagnetic
+  // 2: stripe
+  // 3: sqrt3 x sqrt3 three-sublattice
+  // 4: 2x2
+  settings.cell = 1;
+
+  // wave vector of the spin spiral of engine 3 in units of 2pi
+  // (the default is the 120 degree order of the triangular lattice)
+  settings.spiral_qx = 1.0 / 3.0;
+  settings.spiral_qy = -1.0 / 3.0;
+
+  // Chebyshev expansion for engine 2:
+  // number of moments and of random vectors for the traces (0: exact traces,
+  // O(N^2) per iteration, only meant for validation on small lattices) and
+  // the period of the site colouring the random vectors are split into
+  // (0: no colouring)
+  settings.kpm_moments = 256;
+  settings.kpm_vectors = 4;
+  settings.kpm_probing = 4;
+
+  // eigensolver for engine 0:
+  // 0: full diagonalization in every iteration
+  // 1: Chebyshev filtered subspace iteration of the occupied states (and a
+  //    few above), warm started from the previous iteration
+  settings.eigensolver = 0;
+  settings.filter_degree = 8;
+
+  // diagonalization of dense matrices in engine 0:
+  // 0: Eigen (tridiagonalization + QR)
+  // 1: LAPACK divide and conquer (?syevd)
+  // 2: LAPACK MRRR of only the needed lowest states (?syevr)
+  // (1 and 2 need a build with -D_LAPACK)
+  settings.diagonalizer = 0;
+
+  // precision of the diagonalization in engine 0:
+  // 0: fptype in every iteration
+  // 1: single precision until the largest change of a mean field parameter
+  //    is below refine_below, then fptype until convergence (only with the
+  //    full diagonalization)
+  settings.precision = 1;
+  settings.refine_below = 1e-4;
+
+  // engine 0 with the full diagonalization by Eigen uses matrices of a size
+  // fixed at compile time for the lattices s = 4, 6, 8 and 10 (0: never)
+  settings.fixed_size = 1;
+
+  // mixing of the mean field parameters:
+  // 0: linear with a random factor in (0.25,0.75)
+  // 1: linear with the factor mixing
+  // 2: Anderson/Pulay (DIIS) over the last mixer_history residuals
+  // 3: Broyden over the last mixer_history residuals
+  // (the largest change of a mean field parameter per iteration is limited
+  //  to mixer_max_step, 0 means no limit)
+  settings.mixer = 3;
+  settings.mixing = 0.5;
+  settings.mixer_history = 8;
+  settings.mixer_max_step = 0.2;
+
+  // parallelization:
+  // total number of threads (0: all hardware threads) and number of threads
+  // working on a single calculation (0: choose from s and N_SCC)
+  settings.threads = 0;
+  settings.threads_per_scc = 0;
+
+  // pruning of calculations heading for an excited state:
+  // abort a calculation if the band energy of an iteration after the first
+  // prune_iterations is more than prune_tolerance per site above the lowest
+  // converged energy found so far (engines 0 and 1, 0: no pruning)
+  settings.prune = 0;
+  settings.prune_tolerance = 0.01;
+  settings.prune_iterations = 10;
+
+  // converged solutions are sorted into basins of solutions that agree up to
+  // basin_tolerance in every mean field parameter after a lattice symmetry
+  // (translation, inversion, reflection on the diagonals) and/or spin flip;
+  // no more calculations are started once the lowest basin has been found
+  // adaptive_hits times (0: always run all N_SCC calculations)
+  settings.basin_tolerance = 0.05;
+  settings.adaptive_hits = 0;
 
   // ----------- OTHER SETTINGS -----------
 
@@ -61,6 +179,156 @@ GlobalSettings get_precompiled_settings()
   // 2: plot everything
   settings.plotmode = 2;
 
+  // keep the eigenvectors of the final H_up and H_down in the results
+  // (engine 0 only, 2*(s*s)^2 numbers per calculation)
+  settings.keep_eigenvectors = 0;
+
+  // results written to the binary store results.mfr (read with mfr2csv)
+  // store_all: 0: only the ground state candidate, 1: every calculation
+  // store_eigenvalues: also store the eigenvalues of every record
+  settings.store_all = 0;
+  settings.store_eigenvalues = 0;
+
+  // record the residuals, band energy, mixing factor and the time of the
+  // phases of every iteration and write them to trace.dat (0: off)
+  settings.trace = 0;
+
+  // checkpoints of the running calculations are written every checkpoint
+  // iterations (0: never), --resume continues from them and skips the
+  // finished calculations (the file prefix is set by the driver)
+  settings.checkpoint = 0;
+  settings.resume = 0;
+  settings.checkpoint_prefix.clear();
+
+  // server mode: run the jobs read as JSON lines from stdin ("-") or from
+  // the connections to a Unix socket at the given path (empty: no server)
+  settings.serve.clear();
+
+  // (t_prime,U) grid of the sweep mode relative to t
+  // (empty: no sweep, just calculate the point given above)
+  settings.sweep_t_prime.clear();
+  settings.sweep_U.clear();
+
 
   return settings;
 }
+
+static vector<fptype> parse_list( const string& value )
+{
+  // parse a comma separated list whose entries are either single values or
+  // ranges first:step:last
+  vector<fptype> list;
+  stringstream entries( value );
+  string entry;
+  while ( getline( entries, entry, ',' ) ) {
+    const size_t colon1 = entry.find( ':' );
+    const size_t colon2 = entry.find( ':', colon1 + 1 );
+    if ( colon1 == string::npos || colon2 == string::npos ) {
+      list.push_back( atof( entry.c_str() ) );
+    } else {
+      const fptype first = atof( entry.substr( 0, colon1 ).c_str() );
+      const fptype step = atof( entry.substr( colon1 + 1 ).c_str() );
+      const fptype last = atof( entry.substr( colon2 + 1 ).c_str() );
+      if ( step > 0.0 ) {
+        for ( int i = 0; first + i * step <= last + 1e-3 * step; ++i ) {
+          list.push_back( first + i * step );
+        }
+      }
+    }
+  }
+  return list;
+}
+
+int set_option( GlobalSettings& settings,
+                const string& name, const string& value )
+{
+  // set a single named option from the command line
+  if ( name == "seed" ) {
+    settings.seed = strtoul( value.c_str(), NULL, 10 );
+  } else if ( name == "only_scc" ) {
+    settings.only_scc = atoi( value.c_str() );
+  } else if ( name == "pattern_weights" ) {
+    settings.pattern_weights = parse_list( value );
+  } else if ( name == "pattern_noise" ) {
+    settings.pattern_noise = atof( value.c_str() );
+  } else if ( name == "smearing" ) {
+    settings.smearing = atoi( value.c_str() );
+  } else if ( name == "smearing_width" ) {
+    settings.smearing_width = atof( value.c_str() );
+  } else if ( name == "smearing_anneal" ) {
+    settings.smearing_anneal = atof( value.c_str() );
+  } else if ( name == "smearing_final" ) {
+    settings.smearing_final = atof( value.c_str() );
+  } else if ( name == "filling" ) {
+    settings.filling = atof( value.c_str() );
+  } else if ( name == "engine" ) {
+    settings.engine = atoi( value.c_str() );
+  } else if ( name == "cell" ) {
+    settings.cell = atoi( value.c_str() );
+  } else if ( name == "spiral_qx" ) {
+    settings.spiral_qx = atof( value.c_str() );
+  } else if ( name == "spiral_qy" ) {
+    settings.spiral_qy = atof( value.c_str() );
+  } else if ( name == "kpm_moments" ) {
+    settings.kpm_moments = atoi( value.c_str() );
+  } else if ( name == "kpm_vectors" ) {
+    settings.kpm_vectors = atoi( value.c_str() );
+  } else if ( name == "kpm_probing" ) {
+    settings.kpm_probing = atoi( value.c_str() );
+  } else if ( name == "eigensolver" ) {
+    settings.eigensolver = atoi( value.c_str() );
+  } else if ( name == "diagonalizer" ) {
+    settings.diagonalizer = atoi( value.c_str() );
+  } else if ( name == "filter_degree" ) {
+    settings.filter_degree = atoi( value.c_str() );
+  } else if ( name == "precision" ) {
+    settings.precision = atoi( value.c_str() );
+  } else if ( name == "refine_below" ) {
+    settings.refine_below = atof( value.c_str() );
+  } else if ( name == "fixed_size" ) {
+    settings.fixed_size = atoi( value.c_str() );
+  } else if ( name == "mixer" ) {
+    settings.mixer = atoi( value.c_str() );
+  } else if ( name == "mixing" ) {
+    settings.mixing = atof( value.c_str() );
+  } else if ( name == "mixer_history" ) {
+    settings.mixer_history = atoi( value.c_str() );
+  } else if ( name == "mixer_max_step" ) {
+    settings.mixer_max_step = atof( value.c_str() );
+  } else if ( name == "threads" ) {
+    settings.threads = atoi( value.c_str() );
+  } else if ( name == "threads_per_scc" ) {
+    settings.threads_per_scc = atoi( value.c_str() );
+  } else if ( name == "prune" ) {
+    settings.prune = atoi( value.c_str() );
+  } else if ( name == "prune_tolerance" ) {
+    settings.prune_tolerance = atof( value.c_str() );
+  } else if ( name == "prune_iterations" ) {
+    settings.prune_iterations = atoi( value.c_str() );
+  } else if ( name == "basin_tolerance" ) {
+    settings.basin_tolerance = atof( value.c_str() );
+  } else if ( name == "adaptive_hits" ) {
+    settings.adaptive_hits = atoi( value.c_str() );
+  } else if ( name == "keep_eigenvectors" ) {
+    settings.keep_eigenvectors = atoi( value.c_str() );
+  } else if ( name == "store_all" ) {
+    settings.store_all = atoi( value.c_str() );
+  } else if ( name == "store_eigenvalues" ) {
+    settings.store_eigenvalues = atoi( value.c_str() );
+  } else if ( name == "trace" ) {
+    settings.trace = atoi( value.c_str() );
+  } else if ( name == "checkpoint" ) {
+    settings.checkpoint = atoi( value.c_str() );
+  } else if ( name == "resume" ) {
+    settings.resume = atoi( value.c_str() );
+  } else if ( name == "serve" ) {
+    settings.serve = ( value == "1" ) ? "-" : value;
+  } else if ( name == "sweep_t_prime" ) {
+    settings.sweep_t_prime = parse_list( value );
+  } else if ( name == "sweep_U" ) {
+    settings.sweep_U = parse_list( value );
+  } else {
+    return 1;
+  }
+  return 0;
+}
@@ -21,6 +21,10 @@
 #ifndef __SETTINGS_H_INCLUDED__
 #define __SETTINGS_H_INCLUDED__
 
+#include <string>
+#include <vector>
+using namespace std;
+
 #include "typedefs.hpp"
 
 
@@ -35,10 +39,63 @@ struct GlobalSettings {
   int max_iterations;
   int init;
   fptype kT;
+  vector<fptype> pattern_weights;
+  fptype pattern_noise;
+  unsigned long seed;
+  int only_scc;
+
+  int smearing;
+  fptype smearing_width;
+  fptype smearing_anneal;
+  fptype smearing_final;
+  fptype filling;
+
+  int engine;
+  int cell;
+  fptype spiral_qx;
+  fptype spiral_qy;
+  int kpm_moments;
+  int kpm_vectors;
+  int kpm_probing;
+  int eigensolver;
+  int diagonalizer;
+  int filter_degree;
+  int precision;
+  int fixed_size;
+  fptype refine_below;
+  int mixer;
+  fptype mixing;
+  int mixer_history;
+  fptype mixer_max_step;
+
+  int threads;
+  int threads_per_scc;
+
+  int prune;
+  fptype prune_tolerance;
+  int prune_iterations;
+
+  fptype basin_tolerance;
+  int adaptive_hits;
 
   int plotmode;
+  int keep_eigenvectors;
+  int store_all;
+  int store_eigenvalues;
+  int trace;
+
+  int checkpoint;
+  int resume;
+  string checkpoint_prefix;
+  string serve;
+
+  vector<fptype> sweep_t_prime;
+  vector<fptype> sweep_U;
 };
 
 GlobalSettings get_precompiled_settings();
 
+int set_option( GlobalSettings& settings,
+                const string& name, const string& value );
+
 #endif //__SETTINGS_H_INCLUDED__
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "smearing.hpp"
+#include "scc_calc.hpp"
+
+fptype smeared_occupation( const int& method, const fptype& x )
+{
+  if ( method == 2 ) {
+    // Methfessel-Paxton: 1/2 erfc(x) + A_1 H_1(x) exp(-x^2), A_1 = -1/4sqrt(pi)
+    return 0.5 * erfc( x ) - x * exp( -x * x ) / ( 2.0 * sqrt( M_PI ) );
+  } else {
+    return fermifunc( x, 0.0, 1.0 );
+  }
+}
+
+fptype smeared_delta( const int& method, const fptype& x )
+{
+  if ( method == 2 ) {
+    return exp( -x * x ) * ( 1.5 - x * x ) / sqrt( M_PI );
+  } else {
+    const fptype f = fermifunc( x, 0.0, 1.0 );
+    return f * ( 1.0 - f );
+  }
+}
+
+fptype smearing_width( const GlobalSettings& settings, const int& iter )
+{
+  // the width is reduced by the factor smearing_anneal in every iteration
+  // until it reaches smearing_final
+  if ( settings.smearing_anneal >= 1.0 ) {
+    return settings.smearing_width;
+  }
+  return max( settings.smearing_final,
+              settings.smearing_width
+              * fptype( pow( settings.smearing_anneal, iter - 1 ) ) );
+}
+
+bool smearing_annealed( const GlobalSettings& settings, const int& iter )
+{
+  return settings.smearing_anneal >= 1.0
+         || smearing_width( settings, iter ) <= settings.smearing_final;
+}
+
+static double count_electrons( const int& method, const double& width,
+                               const Array<fptype, Dynamic, 1>& epsilon,
+                               const double& mu, double& dN )
+{
+  // number of electrons in the states and its derivative by mu
+  double N = 0.0;
+  for ( int i = 0; i < epsilon.size(); ++i ) {
+    const double x = ( epsilon( i ) - mu ) / width;
+    N += smeared_occupation( method, x );
+    dN += smeared_delta( method, x ) / width;
+  }
+  return N;
+}
+
+int find_chemical_potential( const int& method, const fptype& width,
+                             const Array<fptype, Dynamic, 1>& epsilon_up,
+                             const Array<fptype, Dynamic, 1>& epsilon_down,
+                             const fptype& N_target, fptype& mu )
+{
+  // Newton's method on N(mu) = N_target, safeguarded by bisection: a step
+  // that leaves the bracket [lo,hi] of the root is replaced by halving it
+  // (needed for small widths, where N(mu) is nearly a step function, and
+  //  Methfessel-Paxton, where N(mu) is not monotonic)
+
+  if ( N_target < 0.0 || N_target > epsilon_up.size() + epsilon_down.size() ) {
+    return 1;
+  }
+
+  double lo = min( epsilon_up.minCoeff(), epsilon_down.minCoeff() )
+              - 10.0 * width;
+  double hi = max( epsilon_up.maxCoeff(), epsilon_down.maxCoeff() )
+              + 10.0 * width;
+  double x = ( mu > lo && mu < hi ) ? mu : 0.5 * ( lo + hi );
+  const double tolerance = 1e-9 * max( 1.0, double( N_target ) );
+
+  for ( int i = 0; i < 200; ++i ) {
+    double dN = 0.0;
+    const double N = count_electrons( method, width, epsilon_up, x, dN )
+                     + count_electrons( method, width, epsilon_down, x, dN );
+    if ( abs( N - N_target ) < tolerance ) {
+      break;
+    }
+    if ( N < N_target ) {
+      lo = x;
+    } else {
+      hi = x;
+    }
+    double next = x - ( N - N_target ) / dN;
+    if ( !( dN > 0.0 ) || !( next > lo && next < hi ) ) {
+      next = 0.5 * ( lo + hi );
+    }
+    // (a degenerate level at mu can make N_target unreachable)
+    if ( hi - lo < 1e-12 * max( 1.0, abs( x ) ) ) {
+      break;
+    }
+    x = next;
+  }
+
+  mu = x;
+  return 0;
+}
+
+void smeared_weights( const int& method, const fptype& width,
+                      const fptype& mu,
+                      const Array<fptype, Dynamic, 1>& epsilon,
+                      Array<fptype, Dynamic, 1>& w )
+{
+  int N = epsilon.size();
+  while ( N > 0 && abs( smeared_occupation( method,
+                          ( epsilon( N - 1 ) - mu ) / width ) ) < 1e-14 ) {
+    --N;
+  }
+  w.resize( N );
+  for ( int i = 0; i < N; ++i ) {
+    w( i ) = smeared_occupation( method, ( epsilon( i ) - mu ) / width );
+  }
+}
+
+static void bracket_mu( const fptype& mu,
+                        const Array<fptype, Dynamic, 1>& epsilon,
+                        fptype& below, fptype& above )
+{
+  for ( int i = 0; i < epsilon.size(); ++i ) {
+    if ( epsilon( i ) > mu ) {
+      above = min( above, epsilon( i ) );
+    } else {
+      below = max( below, epsilon( i ) );
+    }
+  }
+}
+
+fptype gap_at( const fptype& mu,
+               const Array<fptype, Dynamic, 1>& epsilon_up,
+               const Array<fptype, Dynamic, 1>& epsilon_down )
+{
+  fptype below = -numeric_limits<fptype>::infinity();
+  fptype above = numeric_limits<fptype>::infinity();
+  bracket_mu( mu, epsilon_up, below, above );
+  bracket_mu( mu, epsilon_down, below, above );
+  return above - below;
+}
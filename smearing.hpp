@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#ifndef __SMEARING_H_INCLUDED__
+#define __SMEARING_H_INCLUDED__
+
+#include <cmath>
+#include <algorithm>
+#include <limits>
+using namespace std;
+
+#include <eigen3/Eigen/Core>
+using namespace Eigen;
+
+#include "typedefs.hpp"
+#include "settings.hpp"
+
+
+// occupations of the eigenstates at finite temperature or smeared
+// (settings.smearing):
+// 1: Fermi-Dirac
+// 2: Methfessel-Paxton of first order
+// as a function of x = ( E - mu ) / width and their derivative -d/dx
+fptype smeared_occupation( const int& method, const fptype& x );
+fptype smeared_delta( const int& method, const fptype& x );
+
+// width of the smearing in the given iteration (annealed toward
+// smearing_final if smearing_anneal < 1)
+fptype smearing_width( const GlobalSettings& settings, const int& iter );
+
+// whether the annealing has reached smearing_final (always if there is none)
+bool smearing_annealed( const GlobalSettings& settings, const int& iter );
+
+// find the chemical potential mu at which the states of both spins hold
+// N_target electrons (mu is also used as the starting guess)
+int find_chemical_potential( const int& method, const fptype& width,
+                             const Array<fptype, Dynamic, 1>& epsilon_up,
+                             const Array<fptype, Dynamic, 1>& epsilon_down,
+                             const fptype& N_target, fptype& mu );
+
+// occupations of the states at mu, only up to the last state with a
+// nonzero occupation (the eigenvalues are sorted ascending)
+void smeared_weights( const int& method, const fptype& width,
+                      const fptype& mu,
+                      const Array<fptype, Dynamic, 1>& epsilon,
+                      Array<fptype, Dynamic, 1>& w );
+
+// distance of the lowest state above mu to the highest one below it
+fptype gap_at( const fptype& mu,
+               const Array<fptype, Dynamic, 1>& epsilon_up,
+               const Array<fptype, Dynamic, 1>& epsilon_down );
+
+#endif //__SMEARING_H_INCLUDED__
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "trace.hpp"
+
+void add_trace_event( vector<TraceEvent>* trace, const int& id,
+                      const int& iter, const fptype& Delta_n_up,
+                      const fptype& Delta_n_down, const fptype& E_band,
+                      const fptype& mixing, const double& t_start,
+                      const double& t_solved, const double& t_density,
+                      const double& t_mixed )
+{
+  if ( trace == NULL ) {
+    return;
+  }
+  TraceEvent event;
+  event.id = id;
+  event.iter = iter;
+  event.Delta_n_up = Delta_n_up;
+  event.Delta_n_down = Delta_n_down;
+  event.E_band = E_band;
+  event.mixing = mixing;
+  event.t_solve = t_solved - t_start;
+  event.t_density = t_density - t_solved;
+  event.t_mix = t_mixed - t_density;
+  event.t_other = trace_clock( trace ) - t_mixed;
+  trace->push_back( event );
+}
+
+static bool trace_order( const TraceEvent& a, const TraceEvent& b )
+{
+  return a.id < b.id || ( a.id == b.id && a.iter < b.iter );
+}
+
+int write_trace( const string& file, const GlobalSettings& settings,
+                 vector<TraceEvent>& events, TraceSummary& summary )
+{
+  // append the events sorted by calculation and iteration to the trace file
+  // and add them to the summary
+  sort( events.begin(), events.end(), trace_order );
+
+  ofstream out( file.c_str(), ios::app );
+  if ( !out.is_open() ) {
+    return 1;
+  }
+  if ( out.tellp() == 0 ) {
+    out << "# t_prime U id iter Delta_n_up Delta_n_down E_band mixing "
+           "t_solve t_density t_mix t_other" << endl;
+  }
+  out << setiosflags( ios::scientific );
+  out.setf( ios::showpos );
+  out.precision( numeric_limits<fptype>::digits10 + 1 );
+
+  for ( size_t i = 0; i < events.size(); ++i ) {
+    const TraceEvent& e = events[i];
+    out        << settings.t_prime
+        << ' ' << settings.U
+        << ' ' << noshowpos << e.id
+        << ' ' << e.iter << showpos
+        << ' ' << e.Delta_n_up
+        << ' ' << e.Delta_n_down
+        << ' ' << e.E_band
+        << ' ' << e.mixing
+        << ' ' << e.t_solve
+        << ' ' << e.t_density
+        << ' ' << e.t_mix
+        << ' ' << e.t_other << '\n';
+
+    if ( i == 0 || e.id != events[i - 1].id ) {
+      ++summary.calculations;
+    }
+    ++summary.iterations;
+    summary.solve += e.t_solve;
+    summary.density += e.t_density;
+    summary.mix += e.t_mix;
+    summary.other += e.t_other;
+  }
+
+  return out.good() ? 0 : 1;
+}
+
+void print_trace_summary( const TraceSummary& summary )
+{
+  const double total =
+    summary.solve + summary.density + summary.mix + summary.other;
+  if ( summary.iterations == 0 || total <= 0.0 ) {
+    return;
+  }
+  cout << "Traced " << summary.iterations << " iterations of "
+       << summary.calculations << " calculation(s), "
+       << total / summary.iterations << " s per iteration:" << endl;
+  cout << "  solve   " << setw( 12 ) << summary.solve << " s  "
+       << setw( 5 ) << int( 100.0 * summary.solve / total + 0.5 ) << " %" << endl;
+  cout << "  density " << setw( 12 ) << summary.density << " s  "
+       << setw( 5 ) << int( 100.0 * summary.density / total + 0.5 ) << " %" << endl;
+  cout << "  mix     " << setw( 12 ) << summary.mix << " s  "
+       << setw( 5 ) << int( 100.0 * summary.mix / total + 0.5 ) << " %" << endl;
+  cout << "  other   " << setw( 12 ) << summary.other << " s  "
+       << setw( 5 ) << int( 100.0 * summary.other / total + 0.5 ) << " %" << endl;
+}
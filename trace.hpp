@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2012, Robert Rueger <rueger@itp.uni-frankfurt.de>
+ *
+ * This file is part of MFHUB.
+ *
+ * MFHUB is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MFHUB is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MFHUB.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __TRACE_H_INCLUDED__
+#define __TRACE_H_INCLUDED__
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <ctime>
+using namespace std;
+
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+
+#include "typedefs.hpp"
+#include "settings.hpp"
+
+
+// what happened in one iteration of a self-consistency cycle, the times are
+// the wall times of its phases in seconds
+struct TraceEvent {
+  int id;
+  int iter;
+  fptype Delta_n_up, Delta_n_down;
+  fptype E_band;
+  fptype mixing;
+  float t_solve;   // building and diagonalizing H (moments for engine 2)
+  float t_density; // new mean field parameters from the eigenstates
+  float t_mix;     // mixing
+  float t_other;   // pruning check, checkpoints, ...
+};
+
+// the events are collected in a buffer per thread (in the workspace) and
+// only written when all calculations are finished
+
+inline double trace_clock( const vector<TraceEvent>* trace )
+{
+  // (no clock is read if tracing is off)
+  if ( trace == NULL ) {
+    return 0.0;
+  }
+#ifdef _OPENMP
+  return omp_get_wtime();
+#else
+  return clock() / double( CLOCKS_PER_SEC );
+#endif
+}
+
+void add_trace_event( vector<TraceEvent>* trace, const int& id,
+                      const int& iter, const fptype& Delta_n_up,
+                      const fptype& Delta_n_down, const fptype& E_band,
+                      const fptype& mixing, const double& t_start,
+                      const double& t_solved, const double& t_density,
+                      const double& t_mixed );
+
+// where the time of a set of calculations went
+struct TraceSummary {
+  int calculations;
+  int iterations;
+  double solve, density, mix, other;
+
+  TraceSummary()
+    : calculations( 0 ), iterations( 0 ),
+      solve( 0.0 ), density( 0.0 ), mix( 0.0 ), other( 0.0 ) { }
+};
+
+int write_trace( const string& file, const GlobalSettings& settings,
+                 vector<TraceEvent>& events, TraceSummary& summary );
+
+void print_trace_summary( const TraceSummary& summary );
+
+#endif //__TRACE_H_INCLUDED__
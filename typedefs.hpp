@@ -21,6 +21,11 @@
 #ifndef __TYPEDEFS_H_INCLUDED__
 #define __TYPEDEFS_H_INCLUDED__
 
+// (compile with -D_SINGLE to calculate everything in single precision)
+#ifdef _SINGLE
 typedef float fptype;
+#else
+typedef double fptype;
+#endif
 
 #endif //__TYPEDEFS_H_INCLUDED__